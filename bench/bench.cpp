@@ -0,0 +1,503 @@
+// Microbenchmarks for the simulation core
+// ---------------------------------------
+// Times the collision queries, autotiling and a full player tick over randomized
+// positions and velocities, spread over every screen of the built-in level.
+// Also compares jump landings (simulated vs. table) and jump flights (stepped vs. analytic arc),
+// and decodes a compressed 100k-screen level. Analytic arcs of every jump are checked against the stepped simulation.
+// Batched body collisions run with every instruction set the CPU supports and are checked against the scalar ones.
+// Ghosts are baked from random replays and advanced frame by frame, like in a race.
+// Profiler scopes are timed while enabled, their cost is what every phase of a frame pays.
+// Runs headless, build it with CMake (see CMakeLists.txt) and run:
+//
+//     jump_prince_bench [number of ops per benchmark]
+
+#include "sim.h"
+#include "autotile.h"
+#include "jump_table.h"
+#include "arc.h"
+#include "level_compress.h"
+#include "tile_grid.h"
+#include "bodies.h"
+#include "ghosts.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h> // atoi, malloc, free
+#include <string.h> // memcpy
+#include <chrono>
+#include <vector>
+
+#define DEFAULT_NUM_OPS 4000000
+// Simulating a whole jump takes hundreds of ticks, so it gets fewer ops.
+#define SIMULATED_JUMP_OPS_DIVISOR 1000
+// Number of pre-generated random samples, benchmarks cycle through them.
+#define NUM_SAMPLES 4096
+// Screens of the generated level for the compressed level benchmark, about the size of a big community pack
+#define NUM_PACK_SCREENS 100000
+// Times the compressed level is decoded, every decode is a whole level
+#define NUM_PACK_DECODES 20
+// Whole-screen kernels do a few hundred tiles per op, so they get fewer ops.
+#define SCREEN_OPS_DIVISOR 64
+// Bodies on every screen for the batched collision benchmark
+#define NUM_BODIES 1024
+// Ghosts raced against at once, and ticks of their (random) replays
+#define NUM_GHOSTS 5000
+#define GHOST_REPLAY_TICKS 600
+// How far analytic arcs may land from the stepped simulation: tiles, and ticks outside of the tick the simulation landed in
+#define ARC_MAX_POSITION_ERROR 0.15f
+#define ARC_MAX_TICK_ERROR 1.0f
+
+struct Sample {
+    Vector2 position;
+    Vector2 velocity;
+    Vector2 size;
+    Input input;
+};
+
+// Small deterministic random generator (xorshift32), so every run uses the same samples.
+static uint32_t randomState = 0x9e3779b9u;
+
+static uint32_t randomU32() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static float randomFloat(float min, float max) {
+    return min + (max - min) * (float)(randomU32() & 0xffffff) / (float)0xffffff;
+}
+
+// Written to at the end of every benchmark, so the compiler can't remove the work.
+static volatile uint64_t sink = 0;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char* name, int numOps, double seconds) {
+    const double nsPerOp = seconds * 1e9 / numOps;
+    printf("%-40s %10.2f ns/op %14.0f ops/s\n", name, nsPerOp, numOps / seconds);
+}
+
+// Tile grid kernels on every screen of the level
+static void benchTileGrid(const std::vector<ScreenGrid>& grids, int numOps) {
+    const int numScreens = (int)grids.size();
+    const int numScreenOps = numOps / SCREEN_OPS_DIVISOR > 0 ? numOps / SCREEN_OPS_DIVISOR : 1;
+    const int numTiles = TILEMAP_SIZE_X * TILEMAP_SIZE_Y;
+    std::vector<uint16_t> rows((size_t)numScreens * TILEMAP_SIZE_Y);
+    std::vector<AutotileSprite> sprites((size_t)numTiles);
+
+    uint64_t sum = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < numScreenOps; i++) {
+        const int screen = i % numScreens;
+        tileGridGetCollisionRows(grids[screen], &rows[(size_t)screen * TILEMAP_SIZE_Y]);
+        sum += rows[(size_t)screen * TILEMAP_SIZE_Y];
+    }
+    report("tileGridGetCollisionRows", numScreenOps, nowSeconds() - start);
+
+    start = nowSeconds();
+    for (int i = 0; i < numScreenOps; i++) {
+        autotileGrid(grids[i % numScreens], sprites.data());
+        sum += sprites[i % numTiles];
+    }
+    report("autotileGrid", numScreenOps, nowSeconds() - start);
+
+    sink += sum;
+}
+
+int main(int argc, const char** argv) {
+    const int numOps = argc > 1 ? atoi(argv[1]) : DEFAULT_NUM_OPS;
+    if (numOps <= 0) {
+        printf("usage: %s [number of ops per benchmark]\n", argv[0]);
+        return 1;
+    }
+
+    World world = {};
+    worldInitBuiltin(&world);
+
+    // Boxes anywhere in the level, including a bit outside of it.
+    Sample* samples = (Sample*)malloc(sizeof(Sample) * NUM_SAMPLES);
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        Sample* sample = &samples[i];
+        sample->position = { randomFloat(-1.0f, TILEMAP_SIZE_X + 1.0f), randomFloat(world.topY - 2.0f, TILEMAP_SIZE_Y + 2.0f) };
+        sample->velocity = { randomFloat(-25.0f, 25.0f), randomFloat(-25.0f, 25.0f) };
+        sample->size = { randomFloat(0.1f, 0.6f), randomFloat(0.1f, 0.6f) };
+        sample->input = (Input)(randomU32() & (INPUT_JUMP | INPUT_LEFT | INPUT_RIGHT));
+    }
+
+    printf("%d ops per benchmark, %d screens\n\n", numOps, world.numScreens);
+    // Checks which compare two paths and found a difference, the bench fails if there are any
+    int numFailedChecks = 0;
+
+    {
+        uint64_t sum = 0;
+        const double start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const Sample* sample = &samples[i % NUM_SAMPLES];
+            int startX, startY, endX, endY;
+            getTilesOverlappedByBox(&startX, &startY, &endX, &endY, sample->position, sample->size);
+            sum += (uint64_t)(startX + startY + endX + endY);
+        }
+        report("getTilesOverlappedByBox", numOps, nowSeconds() - start);
+        sink += sum;
+    }
+
+    {
+        uint64_t sum = 0;
+        const double start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const Sample* sample = &samples[i % NUM_SAMPLES];
+            sum += isBoxCollidingWithTilemap(&world.mask, world.topY, sample->position, sample->size);
+        }
+        report("isBoxCollidingWithTilemap", numOps, nowSeconds() - start);
+        sink += sum;
+    }
+
+    {
+        float sum = 0.0f;
+        const double start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const Sample* sample = &samples[i % NUM_SAMPLES];
+            Vector2 position = sample->position;
+            Vector2 velocity = sample->velocity;
+            resolveBoxCollisionWithTilemap(&world.mask, world.topY, &position, &velocity, sample->size);
+            sum += position.x + velocity.y;
+        }
+        report("resolveBoxCollisionWithTilemap", numOps, nowSeconds() - start);
+        sink += (uint64_t)sum;
+    }
+
+    {
+        float sum = 0.0f;
+        const double start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const Sample* sample = &samples[i % NUM_SAMPLES];
+            SweepHit hit = {};
+            if (sweepBoxAgainstTilemap(&world.mask, world.topY, sample->position, sample->size, Vector2Scale(sample->velocity, SIM_TICK_DELTA * 4), &hit)) {
+                sum += hit.time;
+            }
+        }
+        report("sweepBoxAgainstTilemap", numOps, nowSeconds() - start);
+        sink += (uint64_t)sum;
+    }
+
+    {
+        uint64_t sum = 0;
+        const double start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const int x = (int)(randomU32() % TILEMAP_SIZE_X);
+            const int y = (int)(randomU32() % (uint32_t)world.numRows);
+            sum += autotileSelectSprite(&world, x, y);
+        }
+        report("autotileSelectSprite", numOps, nowSeconds() - start);
+        sink += sum;
+    }
+
+    {
+        // A full simulation tick: updatePlayer, swept movement and overlap resolve.
+        SimState state = {};
+        simInit(&state, &world);
+        float sum = 0.0f;
+        const double start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const Sample* sample = &samples[i % NUM_SAMPLES];
+            state.player.position = sample->position;
+            state.player.velocity = sample->velocity;
+            state.player.jumpHoldTime = 0.2f;
+            simStep(&state, sample->input, SIM_TICK_DELTA);
+            sum += state.player.position.x;
+        }
+        report("simStep (updatePlayer tick)", numOps, nowSeconds() - start);
+        sink += (uint64_t)sum;
+    }
+
+    {
+        // Where does a jump land: simulated vs. looked up in the precomputed table
+        std::vector<StandingTile> standingTiles;
+        for (int y = 0; y < world.numRows; y++) {
+            for (int x = 0; x < TILEMAP_SIZE_X; x++) {
+                if (isStandingTile(&world, x, y)) standingTiles.push_back({ x, y });
+            }
+        }
+
+        JumpTable table = {};
+        jumpTableInit(&table, &world);
+        for (int i = 0; i < world.numScreens; i++) jumpTableBuildScreen(&table, &world, i);
+
+        const int numJumpOps = numOps / SIMULATED_JUMP_OPS_DIVISOR > 0 ? numOps / SIMULATED_JUMP_OPS_DIVISOR : 1;
+        uint64_t sum = 0;
+        double start = nowSeconds();
+        for (int i = 0; i < numJumpOps; i++) {
+            const StandingTile tile = standingTiles[randomU32() % standingTiles.size()];
+            const JumpResult result = simulateJump(&world, tile, JUMP_START_OFFSETS / 2, (int)(randomU32() % JUMP_CHARGE_BUCKETS), (JumpDirection)(randomU32() % JUMP_DIRECTION_COUNT));
+            sum += (uint64_t)(result.landing.x + result.landing.y);
+        }
+        report("simulateJump", numJumpOps, nowSeconds() - start);
+
+        start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const StandingTile tile = standingTiles[randomU32() % standingTiles.size()];
+            const JumpTableEntry* entry = jumpTableLookup(&table, tile, (int)(randomU32() % JUMP_CHARGE_BUCKETS), (JumpDirection)(randomU32() % JUMP_DIRECTION_COUNT));
+            sum += (uint64_t)(entry->landingX + entry->landingY);
+        }
+        report("jumpTableLookup", numOps, nowSeconds() - start);
+        sink += sum;
+
+        jumpTableFree(&table);
+
+        // Flight after the jump key was released: stepping the simulation vs. the analytic arc
+        std::vector<SimState> jumpStarts;
+        for (int i = 0; i < NUM_SAMPLES; i++) {
+            const StandingTile tile = standingTiles[randomU32() % standingTiles.size()];
+            const Input dirInput = (Input)(randomU32() % 2 ? INPUT_LEFT : INPUT_RIGHT);
+            SimState state = {};
+            simInit(&state, &world);
+            state.player.position = getStandingPosition(&world, tile, JUMP_START_OFFSETS / 2);
+            const int chargeTicks = getJumpChargeTicks((int)(randomU32() % JUMP_CHARGE_BUCKETS));
+            for (int t = 0; t < 4; t++) simStep(&state, 0, SIM_TICK_DELTA);
+            for (int t = 0; t < chargeTicks; t++) simStep(&state, INPUT_JUMP | dirInput, SIM_TICK_DELTA);
+            simStep(&state, dirInput, SIM_TICK_DELTA);
+            jumpStarts.push_back(state);
+        }
+
+        float steppedSum = 0.0f;
+        start = nowSeconds();
+        for (int i = 0; i < numJumpOps; i++) {
+            SimState state = jumpStarts[i % jumpStarts.size()];
+            for (int t = 0; t < JUMP_MAX_TICKS; t++) {
+                const float velocityY = state.player.velocity.y;
+                simStep(&state, 0, SIM_TICK_DELTA);
+                if (velocityY > 0.0f && state.player.velocity.y == 0.0f) break;
+            }
+            steppedSum += state.player.position.x;
+        }
+        report("stepped flight (simStep)", numJumpOps, nowSeconds() - start);
+
+        float arcSum = 0.0f;
+        start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            const Player* player = &jumpStarts[i % jumpStarts.size()].player;
+            const ArcResult arc = traceBallisticArc(&world.mask, world.topY, player->position, PLAYER_SIZE, player->velocity,
+                SIM_TICK_DELTA, JUMP_MAX_TICKS * SIM_TICK_DELTA);
+            arcSum += arc.position.x;
+        }
+        report("traceBallisticArc", numOps, nowSeconds() - start);
+        sink += (uint64_t)(steppedSum + arcSum);
+
+        // Every jump of the level (start offset, charge and direction from every standing tile), the arc has to land
+        // where the stepped simulation lands. Arcs which hit the speed limit or don't land in time aren't comparable.
+        float maxPositionError = 0.0f;
+        float maxTickError = 0.0f;
+        int numCompared = 0;
+        for (const StandingTile tile : standingTiles) {
+            for (int offset = 0; offset < JUMP_START_OFFSETS; offset++) {
+                for (int charge = 0; charge < JUMP_CHARGE_BUCKETS; charge++) {
+                    for (int dir = 0; dir < JUMP_DIRECTION_COUNT; dir++) {
+                        const Input dirInput = (Input)(dir == JUMP_LEFT ? INPUT_LEFT : (dir == JUMP_RIGHT ? INPUT_RIGHT : 0));
+                        SimState state = {};
+                        simInit(&state, &world);
+                        state.player.position = getStandingPosition(&world, tile, offset);
+                        for (int t = 0; t < 4; t++) simStep(&state, 0, SIM_TICK_DELTA);
+                        for (int t = 0; t < getJumpChargeTicks(charge); t++) simStep(&state, INPUT_JUMP | dirInput, SIM_TICK_DELTA);
+                        simStep(&state, dirInput, SIM_TICK_DELTA);
+
+                        const ArcResult arc = traceBallisticArc(&world.mask, world.topY, state.player.position, PLAYER_SIZE,
+                            state.player.velocity, SIM_TICK_DELTA, JUMP_MAX_TICKS * SIM_TICK_DELTA);
+                        if (arc.end != ARC_LANDED) continue;
+
+                        int numTicks = 0;
+                        bool isLanded = false;
+                        while (numTicks < JUMP_MAX_TICKS && !isLanded) {
+                            const float velocityY = state.player.velocity.y;
+                            simStep(&state, 0, SIM_TICK_DELTA);
+                            numTicks++;
+                            isLanded = velocityY > 0.0f && state.player.velocity.y == 0.0f;
+                        }
+                        if (!isLanded) continue;
+
+                        const float positionError = fmaxf(fabsf(arc.position.x - state.player.position.x), fabsf(arc.position.y - state.player.position.y));
+                        // The stepped simulation only knows the landing happened somewhere during its last tick
+                        const float arcTicks = arc.time / SIM_TICK_DELTA;
+                        const float tickError = fmaxf(fmaxf((float)(numTicks - 1) - arcTicks, arcTicks - (float)numTicks), 0.0f);
+                        maxPositionError = fmaxf(maxPositionError, positionError);
+                        maxTickError = fmaxf(maxTickError, tickError);
+                        numCompared++;
+                    }
+                }
+            }
+        }
+        const bool isArcMatching = numCompared > 0 && maxPositionError <= ARC_MAX_POSITION_ERROR && maxTickError <= ARC_MAX_TICK_ERROR;
+        printf("%-40s %s (%i landings, off by up to %.3f tiles and %.2f ticks)\n", "arc matches simStep",
+            isArcMatching ? "yes" : "NO (MISMATCH)", numCompared, maxPositionError, maxTickError);
+        if (!isArcMatching) numFailedChecks++;
+    }
+
+    {
+        std::vector<ScreenGrid> screenGrids;
+        for (int i = 0; i < world.numScreens; i++) screenGrids.push_back(worldGetScreenGrid(&world, i));
+
+        printf("\n");
+        benchTileGrid(screenGrids, numOps);
+    }
+
+    {
+        // Crowds of bodies on every screen, resolved by every instruction set from the same starting state.
+        // Every op is one body, the time includes copying the starting state back before each pass.
+        const BodiesSimd bestSimd = bodiesGetBestSimd();
+        const char* simdNames[] = { "bodiesResolveCollisions (scalar)", "bodiesResolveCollisions (SSE2)", "bodiesResolveCollisions (AVX2)" };
+        std::vector<Bodies> starts(world.numScreens);
+        std::vector<Bodies> results[BODIES_SIMD_AVX2 + 1];
+        for (int i = 0; i < world.numScreens; i++) {
+            bodiesInit(&starts[i], NUM_BODIES, { 0.3f, 0.4f });
+            const float screenTop = world.topY + (float)(i * TILEMAP_SIZE_Y);
+            for (int j = 0; j < NUM_BODIES; j++) {
+                const Vector2 position = { randomFloat(-0.5f, TILEMAP_SIZE_X + 0.5f), screenTop + randomFloat(-0.5f, TILEMAP_SIZE_Y + 0.5f) };
+                bodiesAdd(&starts[i], position, { randomFloat(-25.0f, 25.0f), randomFloat(-25.0f, 25.0f) });
+            }
+        }
+
+        printf("\n");
+        const int numPasses = numOps / (NUM_BODIES * world.numScreens) + 1;
+        for (int simd = BODIES_SIMD_SCALAR; simd <= bestSimd; simd++) {
+            results[simd].resize(world.numScreens);
+            for (int i = 0; i < world.numScreens; i++) bodiesInit(&results[simd][i], NUM_BODIES, starts[i].size);
+
+            const double start = nowSeconds();
+            for (int pass = 0; pass < numPasses; pass++) {
+                for (int i = 0; i < world.numScreens; i++) {
+                    Bodies* bodies = &results[simd][i];
+                    const size_t arraySize = sizeof(float) * NUM_BODIES;
+                    memcpy(bodies->x, starts[i].x, arraySize);
+                    memcpy(bodies->y, starts[i].y, arraySize);
+                    memcpy(bodies->velocityX, starts[i].velocityX, arraySize);
+                    memcpy(bodies->velocityY, starts[i].velocityY, arraySize);
+                    bodies->count = NUM_BODIES;
+                    bodiesResolveCollisionsWith(bodies, &world.mask, world.topY, i, (BodiesSimd)simd);
+                }
+            }
+            report(simdNames[simd], numPasses * NUM_BODIES * world.numScreens, nowSeconds() - start);
+            sink += (uint64_t)results[simd][0].x[0];
+        }
+
+        // Every instruction set has to give exactly the same result as the scalar one
+        bool isExact = true;
+        for (int simd = BODIES_SIMD_SSE2; simd <= bestSimd; simd++) {
+            for (int i = 0; i < world.numScreens; i++) {
+                const size_t arraySize = sizeof(float) * NUM_BODIES;
+                const Bodies* a = &results[BODIES_SIMD_SCALAR][i];
+                const Bodies* b = &results[simd][i];
+                isExact = isExact && memcmp(a->x, b->x, arraySize) == 0 && memcmp(a->y, b->y, arraySize) == 0 &&
+                    memcmp(a->velocityX, b->velocityX, arraySize) == 0 && memcmp(a->velocityY, b->velocityY, arraySize) == 0;
+            }
+        }
+        printf("%-40s %s\n", "bodies match scalar", isExact ? "yes" : "NO (MISMATCH)");
+        if (!isExact) numFailedChecks++;
+
+        for (int simd = BODIES_SIMD_SCALAR; simd <= bestSimd; simd++) {
+            for (Bodies& bodies : results[simd]) bodiesFree(&bodies);
+        }
+        for (Bodies& bodies : starts) bodiesFree(&bodies);
+    }
+
+    {
+        // Empty scopes, so only the profiler's own cost is measured (disabled, the scope is a branch the compiler hoists)
+        printf("\n");
+        profilerSetEnabled(true);
+        const double start = nowSeconds();
+        for (int i = 0; i < numOps; i++) {
+            PROFILE_SCOPE(PROFILE_COLLISION);
+        }
+        report("PROFILE_SCOPE (enabled)", numOps, nowSeconds() - start);
+        profilerBeginFrame();
+        sink += (uint64_t)profilerGetStats(PROFILE_COLLISION).avg;
+        profilerSetEnabled(false);
+    }
+
+    {
+        // Replays of random inputs, held for a while like a player would
+        Ghosts ghosts = {};
+        ReplayRun* runs = (ReplayRun*)malloc(sizeof(ReplayRun) * GHOST_REPLAY_TICKS);
+        double start = nowSeconds();
+        for (int i = 0; i < NUM_GHOSTS; i++) {
+            Replay replay = {};
+            replay.runs = runs;
+            while (replay.numTicks < GHOST_REPLAY_TICKS) {
+                ReplayRun* run = &runs[replay.numRuns++];
+                run->input = (Input)(randomU32() & (INPUT_JUMP | INPUT_LEFT | INPUT_RIGHT));
+                run->count = (uint16_t)(10 + randomU32() % 110);
+                run->delta = SIM_TICK_DELTA;
+                replay.numTicks += run->count;
+            }
+            ghostsAdd(&ghosts, &replay, &world);
+        }
+        const double bakeSeconds = nowSeconds() - start;
+
+        // A frame at 60 FPS is two ticks
+        const int numFrames = numOps / NUM_GHOSTS + 1;
+        start = nowSeconds();
+        for (int frame = 0; frame < numFrames; frame++) {
+            ghostsUpdate(&ghosts, (uint64_t)(frame * 2) % GHOST_REPLAY_TICKS, 0.5f);
+            sink += (uint64_t)ghosts.positions[frame % NUM_GHOSTS].x;
+        }
+        const double seconds = nowSeconds() - start;
+
+        printf("\n%d ghosts: baked in %.1f ms, %.2f MB of tracks\n", NUM_GHOSTS, bakeSeconds * 1e3, ghostsGetMemorySize(&ghosts) / 1e6);
+        report("ghostsUpdate (per ghost)", numFrames * NUM_GHOSTS, seconds);
+        printf("%-40s %10.3f ms/frame\n", "ghostsUpdate", seconds * 1e3 / numFrames);
+
+        free(runs);
+        ghostsFree(&ghosts);
+    }
+
+    {
+        // Big level made of the built-in screens, every fourth one gets an extra platform somewhere,
+        // so the dictionary has hundreds of rows instead of a few dozen
+        Tilemap* screens = (Tilemap*)malloc(sizeof(Tilemap) * NUM_PACK_SCREENS);
+        for (int i = 0; i < NUM_PACK_SCREENS; i++) {
+            memcpy(screens[i], screenTilemaps[randomU32() % screenTilemapsCount], sizeof(Tilemap));
+            if (randomU32() % 4 != 0) continue;
+            uint8_t* row = screens[i][randomU32() % TILEMAP_SIZE_Y];
+            const int startX = 1 + (int)(randomU32() % (TILEMAP_SIZE_X - 2));
+            const int endX = startX + (int)(randomU32() % 4);
+            for (int x = startX; x <= endX && x < TILEMAP_SIZE_X - 1; x++) row[x] = TILE_FULL;
+        }
+        World packWorld = {};
+        worldInit(&packWorld, screens, NUM_PACK_SCREENS);
+
+        size_t compressedSize = 0;
+        uint8_t* compressed = levelCompress(&packWorld, &compressedSize);
+        const size_t imageSize = levelGetDecompressedSize(compressed, compressedSize);
+        uint8_t* image = (uint8_t*)malloc(imageSize);
+
+        CompressedLevelHeader header = {};
+        memcpy(&header, compressed, sizeof(header));
+        printf("\ncompressed level: %d screens, %u dictionary rows, %u bits per row, %.2f MB (%.2f MB decoded)\n",
+            NUM_PACK_SCREENS, header.numDictionaryRows, header.bitsPerIndex, compressedSize / 1e6, imageSize / 1e6);
+
+        bool isValid = true;
+        const double start = nowSeconds();
+        for (int i = 0; i < NUM_PACK_DECODES; i++) {
+            isValid = levelDecompress(compressed, compressedSize, image, imageSize) && isValid;
+        }
+        const double seconds = nowSeconds() - start;
+        report("levelDecompress (per row)", NUM_PACK_DECODES * packWorld.numRows, seconds);
+        printf("%-40s %10.2f ms/level %11.2f GB/s written%s\n", "levelDecompress", seconds * 1e3 / NUM_PACK_DECODES,
+            imageSize * (double)NUM_PACK_DECODES / seconds / 1e9, isValid ? "" : " (INVALID)");
+        if (!isValid) numFailedChecks++;
+        sink += image[imageSize - 1];
+
+        free(image);
+        free(compressed);
+        worldFree(&packWorld);
+        free(screens);
+    }
+
+    free(samples);
+    worldFree(&world);
+    if (numFailedChecks > 0) {
+        printf("\n%d CHECKS FAILED\n", numFailedChecks);
+        return 1;
+    }
+    return 0;
+}
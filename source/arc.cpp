@@ -0,0 +1,230 @@
+#include "arc.h"
+
+#define ARC_GRAVITY_HALF (PLAYER_GRAVITY * 0.5f)
+// A box can't touch more walls than this in one arc, unless it's stuck in a corner.
+#define ARC_MAX_BOUNCES 64
+
+// One parabola of the arc, from the start or the last bounce.
+// Positions are in tilemap local-space: y(t) = origin.y + slopeY * t + ARC_GRAVITY_HALF * t^2
+struct ArcSegment {
+    Vector2 origin;
+    float velocityX;
+    // Vertical velocity at the start of the segment, including the tick correction
+    float slopeY;
+};
+
+static Vector2 getSegmentPosition(const ArcSegment* segment, float time) {
+    return {
+        segment->origin.x + segment->velocityX * time,
+        segment->origin.y + (segment->slopeY + ARC_GRAVITY_HALF * time) * time,
+    };
+}
+
+static float getSegmentSlopeY(const ArcSegment* segment, float time) {
+    return segment->slopeY + PLAYER_GRAVITY * time;
+}
+
+// Time when the leading Y edge of the box reaches row `*nextY`, searching from `fromTime`.
+// If the arc gets to the apex before reaching the row above, it switches to falling
+// and updates `*nextY` and `*stepY` to the row below.
+static float getNextRowTime(const ArcSegment* segment, const Vector2 size, float fromTime, int* nextY, int* stepY) {
+    const float a = ARC_GRAVITY_HALF;
+    const float b = segment->slopeY;
+
+    if (*stepY < 0) {
+        // Rising: the top edge reaches the line below the next row, first root of the quadratic
+        const float line = (float)(*nextY + 1);
+        const float c = segment->origin.y - size.y - line;
+        const float discriminant = b * b - 4.0f * a * c;
+        if (discriminant >= 0.0f) {
+            return fmaxf((-b - sqrtf(discriminant)) / (2.0f * a), fromTime);
+        }
+
+        // Apex comes first, fall from there
+        const float apexTime = fmaxf(-b / (2.0f * a), fromTime);
+        const float bottom = getSegmentPosition(segment, apexTime).y + size.y;
+        *stepY = 1;
+        *nextY = (int)floorf(bottom - SWEEP_EPSILON) + 1;
+        fromTime = apexTime;
+    }
+
+    // Falling: the bottom edge reaches the top line of the next row, second root
+    const float line = (float)*nextY;
+    const float c = segment->origin.y + size.y - line;
+    const float discriminant = fmaxf(b * b - 4.0f * a * c, 0.0f);
+    return fmaxf((-b + sqrtf(discriminant)) / (2.0f * a), fromTime);
+}
+
+// Same rule as `sweepBoxAgainstTilemap`: the face counts if the tile is full and the tile we're coming from isn't.
+static bool isFaceSolid(const CollisionMask* mask, int x, int y, int fromX, int fromY) {
+    return collisionMaskIsFull(mask, x, y) && !collisionMaskIsFull(mask, fromX, fromY);
+}
+
+// Is the box inside of any full tile (not just touching it)?
+static bool isBoxOverlappingTiles(const CollisionMask* mask, Vector2 center, const Vector2 size) {
+    const int startX = (int)floorf(center.x - size.x + SWEEP_EPSILON);
+    const int endX = (int)floorf(center.x + size.x - SWEEP_EPSILON);
+    const int startY = (int)floorf(center.y - size.y + SWEEP_EPSILON);
+    const int endY = (int)floorf(center.y + size.y - SWEEP_EPSILON);
+    const uint32_t spanBits = collisionMaskSpanBits(startX, endX);
+    for (int y = startY; y <= endY; y++) {
+        if (collisionMaskRowBits(mask, y) & spanBits) return true;
+    }
+    return false;
+}
+
+// `moveBoxWithTilemap` stops the motion along the hit axis for the rest of the tick,
+// the clipped velocity only takes effect on the next one. Returns how long the box stays at the surface.
+static float getContactHoldTime(float contactTime, float tickDelta) {
+    if (tickDelta <= 0.0f) return 0.0f;
+    const float nextTickTime = ceilf(contactTime / tickDelta - SWEEP_EPSILON) * tickDelta;
+    return fmaxf(nextTickTime - contactTime, 0.0f);
+}
+
+// Traces the arc the same way `sweepBoxAgainstTilemap` traces a line: we step to whichever
+// row or column the box's leading edges enter first and check the new tiles it covers.
+// Columns are crossed at a constant rate, rows are found by solving the quadratic.
+// Hitting a wall or a ceiling starts a new segment from the contact point with the clipped velocity.
+ArcResult traceBallisticArc(const CollisionMask* mask, float tilemapHeight, Vector2 center, const Vector2 size,
+    Vector2 velocity, float tickDelta, float maxTime) {
+    ArcResult result = {};
+
+    // Shift the vertical velocity to match the semi-implicit Euler ticks
+    const float tickCorrection = PLAYER_GRAVITY * tickDelta * 0.5f;
+    ArcSegment segment = { { center.x, center.y - tilemapHeight }, velocity.x, velocity.y + tickCorrection };
+    float segmentStartTime = 0.0f;
+
+    for (;;) {
+        const float timeLeft = maxTime - segmentStartTime;
+
+        // When the velocity gets clamped, only falling makes it faster
+        float speedLimitTime = INFINITY;
+        const float maxSpeedSqr = PLAYER_MAX_SPEED * PLAYER_MAX_SPEED;
+        if (segment.velocityX * segment.velocityX >= maxSpeedSqr) {
+            speedLimitTime = 0.0f;
+        }
+        else {
+            const float maxVelocityY = sqrtf(maxSpeedSqr - segment.velocityX * segment.velocityX);
+            speedLimitTime = fmaxf((maxVelocityY + tickCorrection - segment.slopeY) / PLAYER_GRAVITY, 0.0f);
+        }
+        const float endTime = fmaxf(fminf(timeLeft, speedLimitTime), 0.0f);
+
+        // Columns
+        int stepX = 0;
+        int nextX = 0;
+        float timeX = INFINITY;
+        float timeDeltaX = 0.0f;
+        if (segment.velocityX > 0.0f) {
+            stepX = 1;
+            nextX = (int)floorf(segment.origin.x + size.x - SWEEP_EPSILON) + 1;
+            timeX = fmaxf(((float)nextX - (segment.origin.x + size.x)) / segment.velocityX, 0.0f);
+            timeDeltaX = 1.0f / segment.velocityX;
+        }
+        else if (segment.velocityX < 0.0f) {
+            stepX = -1;
+            nextX = (int)floorf(segment.origin.x - size.x + SWEEP_EPSILON) - 1;
+            timeX = fmaxf(((float)(nextX + 1) - (segment.origin.x - size.x)) / segment.velocityX, 0.0f);
+            timeDeltaX = -1.0f / segment.velocityX;
+        }
+
+        // Rows
+        int stepY = 0;
+        int nextY = 0;
+        if (segment.slopeY < 0.0f) {
+            stepY = -1;
+            nextY = (int)floorf(segment.origin.y - size.y + SWEEP_EPSILON) - 1;
+        }
+        else {
+            stepY = 1;
+            nextY = (int)floorf(segment.origin.y + size.y - SWEEP_EPSILON) + 1;
+        }
+        float timeY = getNextRowTime(&segment, size, 0.0f, &nextY, &stepY);
+
+        bool isBounced = false;
+        float holdTime = 0.0f;
+        while (!isBounced) {
+            const bool isAxisX = timeX <= timeY;
+            const float time = isAxisX ? timeX : timeY;
+
+            if (time > endTime) {
+                result.end = speedLimitTime < timeLeft ? ARC_SPEED_LIMIT : ARC_TIMEOUT;
+                result.position = getSegmentPosition(&segment, endTime);
+                result.velocity = { segment.velocityX, getSegmentSlopeY(&segment, endTime) - tickCorrection };
+                result.position.y += tilemapHeight;
+                result.time = segmentStartTime + endTime;
+                return result;
+            }
+
+            const Vector2 position = getSegmentPosition(&segment, time);
+
+            if (isAxisX) {
+                // Entering a column, check the rows the box covers.
+                // Just touching a tile (sliding along it) doesn't count.
+                const int startY = (int)floorf(position.y - size.y + SWEEP_EPSILON);
+                const int endY = (int)floorf(position.y + size.y - SWEEP_EPSILON);
+                for (int y = startY; y <= endY; y++) {
+                    if (!isFaceSolid(mask, nextX, y, nextX - stepX, y)) continue;
+
+                    // Bounce off the wall, the box keeps moving along it until the next tick
+                    holdTime = getContactHoldTime(segmentStartTime + time, tickDelta);
+                    Vector2 held = { position.x, getSegmentPosition(&segment, time + holdTime).y };
+                    if (isBoxOverlappingTiles(mask, held, size)) {
+                        holdTime = 0.0f;
+                        held = position;
+                    }
+                    const float bounceX = collisionMaskGetMaterial(mask, nextX, y)->bounceX;
+                    segment = { held, -segment.velocityX * bounceX, getSegmentSlopeY(&segment, time + holdTime) };
+                    isBounced = true;
+                    break;
+                }
+
+                nextX += stepX;
+                timeX += timeDeltaX;
+            }
+            else {
+                // Entering a row, check the columns the box covers
+                const int startX = (int)floorf(position.x - size.x + SWEEP_EPSILON);
+                const int endX = (int)floorf(position.x + size.x - SWEEP_EPSILON);
+                for (int x = startX; x <= endX; x++) {
+                    if (!isFaceSolid(mask, x, nextY, x, nextY - stepY)) continue;
+
+                    if (stepY > 0) {
+                        result.end = ARC_LANDED;
+                        result.position = { position.x, position.y + tilemapHeight };
+                        result.velocity = { segment.velocityX, getSegmentSlopeY(&segment, time) - tickCorrection };
+                        result.time = segmentStartTime + time;
+                        return result;
+                    }
+
+                    // Hit a ceiling, the vertical velocity is clipped to zero
+                    holdTime = getContactHoldTime(segmentStartTime + time, tickDelta);
+                    Vector2 held = { getSegmentPosition(&segment, time + holdTime).x, position.y };
+                    if (isBoxOverlappingTiles(mask, held, size)) {
+                        holdTime = 0.0f;
+                        held = position;
+                    }
+                    segment = { held, segment.velocityX, tickCorrection };
+                    isBounced = true;
+                    break;
+                }
+
+                if (!isBounced) {
+                    nextY += stepY;
+                    timeY = getNextRowTime(&segment, size, time, &nextY, &stepY);
+                }
+            }
+
+            if (isBounced) {
+                segmentStartTime += time + holdTime;
+                result.numBounces++;
+                if (result.numBounces > ARC_MAX_BOUNCES) {
+                    result.end = ARC_TIMEOUT;
+                    result.position = { segment.origin.x, segment.origin.y + tilemapHeight };
+                    result.velocity = { segment.velocityX, segment.slopeY - tickCorrection };
+                    result.time = segmentStartTime;
+                    return result;
+                }
+            }
+        }
+    }
+}
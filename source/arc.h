@@ -0,0 +1,43 @@
+// Ballistic arcs
+// --------------
+// Between ground contacts the player only falls: constant gravity, no input, horizontal bounces off walls.
+// Instead of stepping the simulation tick by tick, `traceBallisticArc` solves the parabola against the tile grid
+// directly and finds the first contact with a full tile, bouncing off walls on the way.
+// Used for search and prediction (where does this jump land), it's orders of magnitude faster than `simStep`.
+//
+// The stepped simulation integrates with semi-implicit Euler, so after `n` ticks of `dt` the position is
+//   p + v * t + g/2 * (t^2 + t * dt), where t = n * dt
+// which is again a parabola, with the starting vertical velocity shifted by `g * dt / 2`.
+// Passing the tick length makes the arc go exactly through the positions of the stepped simulation
+// (the simulation moves in straight lines between them, so contacts can still differ by a fraction of a tick).
+//
+// Walls bounce with their material's `bounceX`. Wind zones aren't taken into account, arcs through them are only approximate.
+#pragma once
+
+#include "sim.h"
+
+enum ArcEnd {
+    // Hit a floor, `updatePlayer` will stop the player on the next tick.
+    ARC_LANDED,
+    // Reached PLAYER_MAX_SPEED, the simulation clamps the velocity from here on and the arc isn't a parabola anymore.
+    ARC_SPEED_LIMIT,
+    // Didn't hit any floor in time.
+    ARC_TIMEOUT,
+};
+
+struct ArcResult {
+    ArcEnd end;
+    // Where the box is (and how fast it moves) when the arc ended.
+    Vector2 position;
+    Vector2 velocity;
+    // Seconds since the start of the arc
+    float time;
+    // Number of walls and ceilings hit on the way
+    int numBounces;
+};
+
+// Follow a falling box from `center`, moving with `velocity` (as stored in `Player` after `simStep`).
+// param `tickDelta`: tick length of the stepped simulation to match, zero for the continuous parabola
+// param `maxTime`: give up after this many seconds
+ArcResult traceBallisticArc(const CollisionMask* mask, float tilemapHeight, Vector2 center, const Vector2 size,
+    Vector2 velocity, float tickDelta, float maxTime);
@@ -0,0 +1,18 @@
+#include "autotile.h"
+
+AutotileSprite autotileSelectSprite(const World* world, int x, int y) {
+    if (!worldIsTileFull(world, x, y)) return AUTOTILE_NONE;
+
+    // Neighbors (these can be on the neighboring screens)
+    uint32_t neighbors = 0;
+    if (isTileFull(worldGetTileFullOutside(world, x, y - 1))) neighbors |= AUTOTILE_TOP;
+    if (isTileFull(worldGetTileFullOutside(world, x, y + 1))) neighbors |= AUTOTILE_BOTTOM;
+    if (isTileFull(worldGetTileFullOutside(world, x + 1, y))) neighbors |= AUTOTILE_RIGHT;
+    if (isTileFull(worldGetTileFullOutside(world, x - 1, y))) neighbors |= AUTOTILE_LEFT;
+    if (isTileFull(worldGetTileFullOutside(world, x + 1, y - 1))) neighbors |= AUTOTILE_TOP_RIGHT;
+    if (isTileFull(worldGetTileFullOutside(world, x + 1, y + 1))) neighbors |= AUTOTILE_BOTTOM_RIGHT;
+    if (isTileFull(worldGetTileFullOutside(world, x - 1, y - 1))) neighbors |= AUTOTILE_TOP_LEFT;
+    if (isTileFull(worldGetTileFullOutside(world, x - 1, y + 1))) neighbors |= AUTOTILE_BOTTOM_LEFT;
+
+    return autotileSelectSpriteFromNeighbors(neighbors);
+}
@@ -0,0 +1,141 @@
+// Autotiling
+// ----------
+// Picks a sprite from the tileset for every full tile, based on which of it's neighbors are full,
+// so the level gets nice edges and corners. The level doesn't change while playing,
+// so the result is computed once per screen and cached (see `ScreenCache` in "screen_cache.h").
+#pragma once
+
+#include "sim.h"
+#include "tile_grid.h"
+
+// Cached sprite index of a tile: sprite X in the low 4 bits, sprite Y in the high 4 bits.
+// AUTOTILE_NONE means there is nothing to draw.
+typedef uint8_t AutotileSprite;
+
+#define AUTOTILE_NONE 0xff
+#define autotileSpriteX(sprite) ((sprite) & 0xf)
+#define autotileSpriteY(sprite) ((sprite) >> 4)
+
+// Which neighbors of a tile are solid (tiles outside of the level count as solid).
+// Every solid material connects with the others, they only differ in tint (`TileMaterial::tint`).
+enum AutotileNeighborBits {
+    AUTOTILE_TOP = 1 << 0,
+    AUTOTILE_BOTTOM = 1 << 1,
+    AUTOTILE_LEFT = 1 << 2,
+    AUTOTILE_RIGHT = 1 << 3,
+    AUTOTILE_TOP_LEFT = 1 << 4,
+    AUTOTILE_TOP_RIGHT = 1 << 5,
+    AUTOTILE_BOTTOM_LEFT = 1 << 6,
+    AUTOTILE_BOTTOM_RIGHT = 1 << 7,
+};
+
+// The autotile rules: sprite of a full tile with the `neighbors` (`AutotileNeighborBits`).
+// Inline, so the grid loops in `autotileGrid` get specialized around it.
+inline AutotileSprite autotileSelectSpriteFromNeighbors(uint32_t neighbors) {
+    const bool isTop = (neighbors & AUTOTILE_TOP) != 0;
+    const bool isBottom = (neighbors & AUTOTILE_BOTTOM) != 0;
+    const bool isLeft = (neighbors & AUTOTILE_LEFT) != 0;
+    const bool isRight = (neighbors & AUTOTILE_RIGHT) != 0;
+    const bool isTopLeft = (neighbors & AUTOTILE_TOP_LEFT) != 0;
+    const bool isTopRight = (neighbors & AUTOTILE_TOP_RIGHT) != 0;
+    const bool isBottomLeft = (neighbors & AUTOTILE_BOTTOM_LEFT) != 0;
+    const bool isBottomRight = (neighbors & AUTOTILE_BOTTOM_RIGHT) != 0;
+
+    // This logic is bit of a hack...
+    int spriteX = 1;
+    int spriteY = 1;
+    if (isTop) spriteY += 1;
+    if (isBottom) spriteY -= 1;
+    if (isRight) spriteX -= 1;
+    if (isLeft) spriteX += 1;
+
+    if (!isTop && !isBottom && !isRight && !isLeft) {
+        spriteX = 3;
+        spriteY = 3;
+    }
+
+    if (!isLeft && !isRight && spriteX == 1) spriteX = 3;
+    if (!isTop && !isBottom && spriteY == 1) spriteY = 3;
+
+    if (spriteX == 1 && spriteY == 1) {
+        if (!isTopRight && isBottomRight &&
+            isTopLeft && isBottomLeft) {
+            spriteX = 4;
+            spriteY = 2;
+        }
+
+        if (isTopRight && !isBottomRight &&
+            isTopLeft && isBottomLeft) {
+            spriteX = 4;
+            spriteY = 0;
+        }
+
+        if (isTopRight && isBottomRight &&
+            !isTopLeft && isBottomLeft) {
+            spriteX = 6;
+            spriteY = 2;
+        }
+
+        if (isTopRight && isBottomRight &&
+            isTopLeft && !isBottomLeft) {
+            spriteX = 6;
+            spriteY = 0;
+        }
+    }
+
+    return (AutotileSprite)(spriteX | (spriteY << 4));
+}
+
+// Run the autotile rules for a single tile (row `y` of the world grid).
+AutotileSprite autotileSelectSprite(const World* world, int x, int y);
+
+// Solid tiles of a row, shifted left by one bit like `collisionMaskRowBits`.
+// Tiles outside of the grid count as full, so does a missing (NULL) row.
+template <typename Grid>
+inline uint32_t autotileGetRowBits(const Grid& grid, const uint8_t* row) {
+    if (!row) return ~0u;
+    uint32_t bits = ~(((1u << grid.getSizeX()) - 1u) << 1);
+    for (int x = 0; x < grid.getSizeX(); x++) {
+        bits |= (uint32_t)isTileFull(row[x]) << (x + 1);
+    }
+    return bits;
+}
+
+// Sprites of every tile of the grid (`getSizeX() * getSizeY()`, row by row).
+// Same as `autotileSelectSprite` on every tile, but every row is only scanned once.
+template <typename Grid>
+inline void autotileGrid(const Grid& grid, AutotileSprite* outSprites) {
+    uint32_t above = autotileGetRowBits(grid, grid.rowAbove);
+    uint32_t current = autotileGetRowBits(grid, tileGridGetRow(grid, 0));
+    for (int y = 0; y < grid.getSizeY(); y++) {
+        const uint8_t* tiles = tileGridGetRow(grid, y);
+        const uint32_t below = autotileGetRowBits(grid, y + 1 < grid.getSizeY() ? tileGridGetRow(grid, y + 1) : grid.rowBelow);
+
+        for (int x = 0; x < grid.getSizeX(); x++) {
+            AutotileSprite sprite = AUTOTILE_NONE;
+            if (isTileFull(tiles[x])) {
+                // Bit of the tile in the row bits, the neighbors are next to it
+                const int bit = x + 1;
+                uint32_t neighbors = 0;
+                neighbors |= ((above >> bit) & 1u) * AUTOTILE_TOP;
+                neighbors |= ((below >> bit) & 1u) * AUTOTILE_BOTTOM;
+                neighbors |= ((current >> (bit - 1)) & 1u) * AUTOTILE_LEFT;
+                neighbors |= ((current >> (bit + 1)) & 1u) * AUTOTILE_RIGHT;
+                neighbors |= ((above >> (bit - 1)) & 1u) * AUTOTILE_TOP_LEFT;
+                neighbors |= ((above >> (bit + 1)) & 1u) * AUTOTILE_TOP_RIGHT;
+                neighbors |= ((below >> (bit - 1)) & 1u) * AUTOTILE_BOTTOM_LEFT;
+                neighbors |= ((below >> (bit + 1)) & 1u) * AUTOTILE_BOTTOM_RIGHT;
+                sprite = autotileSelectSpriteFromNeighbors(neighbors);
+            }
+            outSprites[y * grid.getSizeX() + x] = sprite;
+        }
+
+        above = current;
+        current = below;
+    }
+}
+
+// Sprites of a whole screen of the world, TILEMAP_SIZE_X * TILEMAP_SIZE_Y of them.
+inline void autotileScreen(const World* world, int screenIndex, AutotileSprite* outSprites) {
+    autotileGrid(worldGetScreenGrid(world, screenIndex), outSprites);
+}
@@ -0,0 +1,378 @@
+#include "bodies.h"
+#include "trace.h"
+#include <math.h> // fminf
+#include <stdlib.h> // malloc, free
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BODIES_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h> // __cpuidex, _xgetbv
+#endif
+#endif
+
+// GCC and Clang only compile AVX2 intrinsics in functions marked for it, MSVC always does
+#if defined(__GNUC__)
+#define BODIES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BODIES_TARGET_AVX2
+#endif
+
+// Arrays are aligned for the widest loads
+#define BODIES_ALIGNMENT 32
+
+// Reference implementation, and the fallback for the bodies which don't fill a whole batch.
+static void resolveScalar(Bodies* bodies, const CollisionMask* mask, float tilemapHeight, int start) {
+    for (int i = start; i < bodies->count; i++) {
+        Vector2 center = { bodies->x[i], bodies->y[i] };
+        Vector2 velocity = { bodies->velocityX[i], bodies->velocityY[i] };
+        resolveBoxCollisionWithTilemap(mask, tilemapHeight, &center, &velocity, bodies->size);
+        bodies->x[i] = center.x;
+        bodies->y[i] = center.y;
+        bodies->velocityX[i] = velocity.x;
+        bodies->velocityY[i] = velocity.y;
+    }
+}
+
+#ifdef BODIES_X64
+
+// Columns of the screen tables, from x = -1 to x = TILEMAP_SIZE_X (everything further outside is the same)
+#define TABLE_SIZE_X (TILEMAP_SIZE_X + 2)
+// Rows of the screen tables: bodies can touch the 2 rows above and below the screen, and their neighbors get checked too
+#define TABLE_MARGIN_Y 3
+#define TABLE_SIZE_Y (TILEMAP_SIZE_Y + 2 * TABLE_MARGIN_Y)
+
+// Tiles of one screen, laid out for gathers.
+struct ScreenTables {
+    // Tilemap row of the table's first row
+    int firstRow;
+    // -1 (all bits set) if the tile is full, 0 if not, so it can be used as a SIMD mask directly
+    int32_t isFull[TABLE_SIZE_Y * TABLE_SIZE_X];
+    float bounceX[TABLE_SIZE_Y * TABLE_SIZE_X];
+};
+
+static void buildScreenTables(ScreenTables* tables, const CollisionMask* mask, int screenIndex) {
+    tables->firstRow = screenIndex * TILEMAP_SIZE_Y - TABLE_MARGIN_Y;
+    for (int row = 0; row < TABLE_SIZE_Y; row++) {
+        for (int column = 0; column < TABLE_SIZE_X; column++) {
+            const int x = column - 1;
+            const int y = tables->firstRow + row;
+            tables->isFull[row * TABLE_SIZE_X + column] = collisionMaskIsFull(mask, x, y) ? -1 : 0;
+            tables->bounceX[row * TABLE_SIZE_X + column] = collisionMaskGetMaterial(mask, x, y)->bounceX;
+        }
+    }
+}
+
+static int getTableIndex(const ScreenTables* tables, int x, int y) {
+    int column = x + 1;
+    int row = y - tables->firstRow;
+    column = column < 0 ? 0 : (column >= TABLE_SIZE_X ? TABLE_SIZE_X - 1 : column);
+    row = row < 0 ? 0 : (row >= TABLE_SIZE_Y ? TABLE_SIZE_Y - 1 : row);
+    return row * TABLE_SIZE_X + column;
+}
+
+// Same rounding as `resolveBoxCollisionWithTilemap` (`size.y + 0.5` is a double there).
+static Vector2 getSizeSum(Vector2 size) {
+    return { size.x + 0.5f, (float)(size.y + 0.5) };
+}
+
+// The kernels follow `resolveBoxCollisionWithTilemap` step by step, with every lane being one body.
+// Bodies are smaller than a tile, so they overlap at most 2x2 tiles, visited in the same order (X outer, Y inner).
+// Each step is done on all lanes, the result is only kept in the lanes where the tile is in range, full and has an edge.
+
+// floorf for SSE2 (it doesn't have a rounding instruction): truncate and correct the negative values.
+static inline __m128i floorToIntSse2(__m128 value) {
+    const __m128i truncated = _mm_cvttps_epi32(value);
+    const __m128 isTooBig = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), value);
+    return _mm_add_epi32(truncated, _mm_castps_si128(isTooBig));
+}
+
+static inline __m128 selectSse2(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// SSE2 doesn't have gathers, the table lookups are done one lane at a time.
+static inline __m128i gatherFullSse2(const ScreenTables* tables, __m128i x, __m128i y) {
+    alignas(16) int32_t xs[4];
+    alignas(16) int32_t ys[4];
+    alignas(16) int32_t result[4];
+    _mm_store_si128((__m128i*)xs, x);
+    _mm_store_si128((__m128i*)ys, y);
+    for (int i = 0; i < 4; i++) result[i] = tables->isFull[getTableIndex(tables, xs[i], ys[i])];
+    return _mm_load_si128((const __m128i*)result);
+}
+
+static inline __m128 gatherBounceSse2(const ScreenTables* tables, __m128i x, __m128i y) {
+    alignas(16) int32_t xs[4];
+    alignas(16) int32_t ys[4];
+    alignas(16) float result[4];
+    _mm_store_si128((__m128i*)xs, x);
+    _mm_store_si128((__m128i*)ys, y);
+    for (int i = 0; i < 4; i++) result[i] = tables->bounceX[getTableIndex(tables, xs[i], ys[i])];
+    return _mm_load_ps(result);
+}
+
+// Returns the number of bodies resolved (whole batches of 4).
+static int resolveSse2(Bodies* bodies, const ScreenTables* tables, float tilemapHeight) {
+    const Vector2 sizeSum = getSizeSum(bodies->size);
+    const __m128 height = _mm_set1_ps(tilemapHeight);
+    const __m128 sizeX = _mm_set1_ps(bodies->size.x);
+    const __m128 sizeY = _mm_set1_ps(bodies->size.y);
+    const __m128 sumX = _mm_set1_ps(sizeSum.x);
+    const __m128 sumY = _mm_set1_ps(sizeSum.y);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+
+    const int end = bodies->count / 4 * 4;
+    for (int i = 0; i < end; i += 4) {
+        __m128 cx = _mm_load_ps(&bodies->x[i]);
+        __m128 cy = _mm_sub_ps(_mm_load_ps(&bodies->y[i]), height);
+        __m128 vx = _mm_load_ps(&bodies->velocityX[i]);
+        __m128 vy = _mm_load_ps(&bodies->velocityY[i]);
+
+        const __m128i startX = floorToIntSse2(_mm_sub_ps(cx, sizeX));
+        const __m128i startY = floorToIntSse2(_mm_sub_ps(cy, sizeY));
+        const __m128i endX = floorToIntSse2(_mm_add_ps(cx, sizeX));
+        const __m128i endY = floorToIntSse2(_mm_add_ps(cy, sizeY));
+
+        for (int dx = 0; dx < 2; dx++) {
+            for (int dy = 0; dy < 2; dy++) {
+                const __m128i tx = _mm_add_epi32(startX, _mm_set1_epi32(dx));
+                const __m128i ty = _mm_add_epi32(startY, _mm_set1_epi32(dy));
+                const __m128i isOutOfRange = _mm_or_si128(_mm_cmpgt_epi32(tx, endX), _mm_cmpgt_epi32(ty, endY));
+
+                const __m128 boxX = _mm_add_ps(half, _mm_cvtepi32_ps(tx));
+                const __m128 boxY = _mm_add_ps(half, _mm_cvtepi32_ps(ty));
+                const __m128 distX = _mm_sub_ps(_mm_andnot_ps(signBit, _mm_sub_ps(cx, boxX)), sumX);
+                const __m128 distY = _mm_sub_ps(_mm_andnot_ps(signBit, _mm_sub_ps(cy, boxY)), sumY);
+
+                const __m128 isRight = _mm_cmpgt_ps(cx, boxX);
+                const __m128 isBelow = _mm_cmpgt_ps(cy, boxY);
+                // +1 towards the box, -1 away from it
+                const __m128i stepX = _mm_sub_epi32(_mm_and_si128(_mm_castps_si128(isRight), two), one);
+                const __m128i stepY = _mm_sub_epi32(_mm_and_si128(_mm_castps_si128(isBelow), two), one);
+
+                const __m128 isFull = _mm_castsi128_ps(gatherFullSse2(tables, tx, ty));
+                const __m128 isXEmpty = _mm_castsi128_ps(_mm_xor_si128(gatherFullSse2(tables, _mm_add_epi32(tx, stepX), ty), _mm_set1_epi32(-1)));
+                const __m128 isYEmpty = _mm_castsi128_ps(_mm_xor_si128(gatherFullSse2(tables, tx, _mm_add_epi32(ty, stepY)), _mm_set1_epi32(-1)));
+
+                __m128 isActive = _mm_andnot_ps(_mm_castsi128_ps(isOutOfRange), isFull);
+                isActive = _mm_andnot_ps(_mm_or_ps(_mm_cmpgt_ps(distX, zero), _mm_cmpgt_ps(distY, zero)), isActive);
+                isActive = _mm_and_ps(isActive, _mm_or_ps(isXEmpty, isYEmpty));
+                if (_mm_movemask_ps(isActive) == 0) continue;
+
+                const __m128 isClipAxisX = _mm_and_ps(isXEmpty, _mm_or_ps(_mm_andnot_ps(isYEmpty, isActive), _mm_cmpgt_ps(distX, distY)));
+                const __m128 isClipX = _mm_and_ps(isActive, isClipAxisX);
+                const __m128 isClipY = _mm_andnot_ps(isClipAxisX, isActive);
+
+                // Clamp to the surface, bounce if moving into it
+                const __m128 bounceX = gatherBounceSse2(tables, tx, ty);
+                const __m128 surfaceX = selectSse2(isRight, _mm_add_ps(boxX, sumX), _mm_sub_ps(boxX, sumX));
+                const __m128 isIntoX = selectSse2(isRight, _mm_cmplt_ps(vx, zero), _mm_cmpgt_ps(vx, zero));
+                const __m128 bouncedX = selectSse2(isIntoX, _mm_mul_ps(_mm_xor_ps(vx, signBit), bounceX), vx);
+                cx = selectSse2(isClipX, surfaceX, cx);
+                vx = selectSse2(isClipX, bouncedX, vx);
+
+                const __m128 surfaceY = selectSse2(isBelow, _mm_add_ps(boxY, sumY), _mm_sub_ps(boxY, sumY));
+                const __m128 clippedY = selectSse2(isBelow, _mm_max_ps(vy, zero), _mm_min_ps(vy, zero));
+                cy = selectSse2(isClipY, surfaceY, cy);
+                vy = selectSse2(isClipY, clippedY, vy);
+            }
+        }
+
+        _mm_store_ps(&bodies->x[i], cx);
+        _mm_store_ps(&bodies->y[i], _mm_add_ps(cy, height));
+        _mm_store_ps(&bodies->velocityX[i], vx);
+        _mm_store_ps(&bodies->velocityY[i], vy);
+    }
+    return end;
+}
+
+BODIES_TARGET_AVX2 static inline __m256i getTableIndexAvx2(const ScreenTables* tables, __m256i x, __m256i y) {
+    const __m256i column = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(1)), _mm256_setzero_si256()), _mm256_set1_epi32(TABLE_SIZE_X - 1));
+    const __m256i row = _mm256_min_epi32(_mm256_max_epi32(_mm256_sub_epi32(y, _mm256_set1_epi32(tables->firstRow)), _mm256_setzero_si256()), _mm256_set1_epi32(TABLE_SIZE_Y - 1));
+    return _mm256_add_epi32(_mm256_mullo_epi32(row, _mm256_set1_epi32(TABLE_SIZE_X)), column);
+}
+
+BODIES_TARGET_AVX2 static inline __m256 gatherFullAvx2(const ScreenTables* tables, __m256i x, __m256i y) {
+    return _mm256_castsi256_ps(_mm256_i32gather_epi32(tables->isFull, getTableIndexAvx2(tables, x, y), 4));
+}
+
+// Same as `resolveSse2`, 8 bodies at a time and with real gathers.
+BODIES_TARGET_AVX2 static int resolveAvx2(Bodies* bodies, const ScreenTables* tables, float tilemapHeight) {
+    const Vector2 sizeSum = getSizeSum(bodies->size);
+    const __m256 height = _mm256_set1_ps(tilemapHeight);
+    const __m256 sizeX = _mm256_set1_ps(bodies->size.x);
+    const __m256 sizeY = _mm256_set1_ps(bodies->size.y);
+    const __m256 sumX = _mm256_set1_ps(sizeSum.x);
+    const __m256 sumY = _mm256_set1_ps(sizeSum.y);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 allBits = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+
+    const int end = bodies->count / 8 * 8;
+    for (int i = 0; i < end; i += 8) {
+        __m256 cx = _mm256_load_ps(&bodies->x[i]);
+        __m256 cy = _mm256_sub_ps(_mm256_load_ps(&bodies->y[i]), height);
+        __m256 vx = _mm256_load_ps(&bodies->velocityX[i]);
+        __m256 vy = _mm256_load_ps(&bodies->velocityY[i]);
+
+        const __m256i startX = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_sub_ps(cx, sizeX)));
+        const __m256i startY = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_sub_ps(cy, sizeY)));
+        const __m256i endX = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(cx, sizeX)));
+        const __m256i endY = _mm256_cvttps_epi32(_mm256_floor_ps(_mm256_add_ps(cy, sizeY)));
+
+        for (int dx = 0; dx < 2; dx++) {
+            for (int dy = 0; dy < 2; dy++) {
+                const __m256i tx = _mm256_add_epi32(startX, _mm256_set1_epi32(dx));
+                const __m256i ty = _mm256_add_epi32(startY, _mm256_set1_epi32(dy));
+                const __m256i isOutOfRange = _mm256_or_si256(_mm256_cmpgt_epi32(tx, endX), _mm256_cmpgt_epi32(ty, endY));
+
+                const __m256 boxX = _mm256_add_ps(half, _mm256_cvtepi32_ps(tx));
+                const __m256 boxY = _mm256_add_ps(half, _mm256_cvtepi32_ps(ty));
+                const __m256 distX = _mm256_sub_ps(_mm256_andnot_ps(signBit, _mm256_sub_ps(cx, boxX)), sumX);
+                const __m256 distY = _mm256_sub_ps(_mm256_andnot_ps(signBit, _mm256_sub_ps(cy, boxY)), sumY);
+
+                const __m256 isRight = _mm256_cmp_ps(cx, boxX, _CMP_GT_OQ);
+                const __m256 isBelow = _mm256_cmp_ps(cy, boxY, _CMP_GT_OQ);
+                const __m256i stepX = _mm256_sub_epi32(_mm256_and_si256(_mm256_castps_si256(isRight), two), one);
+                const __m256i stepY = _mm256_sub_epi32(_mm256_and_si256(_mm256_castps_si256(isBelow), two), one);
+
+                const __m256 isFull = gatherFullAvx2(tables, tx, ty);
+                const __m256 isXEmpty = _mm256_xor_ps(gatherFullAvx2(tables, _mm256_add_epi32(tx, stepX), ty), allBits);
+                const __m256 isYEmpty = _mm256_xor_ps(gatherFullAvx2(tables, tx, _mm256_add_epi32(ty, stepY)), allBits);
+
+                __m256 isActive = _mm256_andnot_ps(_mm256_castsi256_ps(isOutOfRange), isFull);
+                isActive = _mm256_andnot_ps(_mm256_or_ps(_mm256_cmp_ps(distX, zero, _CMP_GT_OQ), _mm256_cmp_ps(distY, zero, _CMP_GT_OQ)), isActive);
+                isActive = _mm256_and_ps(isActive, _mm256_or_ps(isXEmpty, isYEmpty));
+                if (_mm256_movemask_ps(isActive) == 0) continue;
+
+                const __m256 isClipAxisX = _mm256_and_ps(isXEmpty, _mm256_or_ps(_mm256_andnot_ps(isYEmpty, isActive), _mm256_cmp_ps(distX, distY, _CMP_GT_OQ)));
+                const __m256 isClipX = _mm256_and_ps(isActive, isClipAxisX);
+                const __m256 isClipY = _mm256_andnot_ps(isClipAxisX, isActive);
+
+                const __m256 bounceX = _mm256_i32gather_ps(tables->bounceX, getTableIndexAvx2(tables, tx, ty), 4);
+                const __m256 surfaceX = _mm256_blendv_ps(_mm256_sub_ps(boxX, sumX), _mm256_add_ps(boxX, sumX), isRight);
+                const __m256 isIntoX = _mm256_blendv_ps(_mm256_cmp_ps(vx, zero, _CMP_GT_OQ), _mm256_cmp_ps(vx, zero, _CMP_LT_OQ), isRight);
+                const __m256 bouncedX = _mm256_blendv_ps(vx, _mm256_mul_ps(_mm256_xor_ps(vx, signBit), bounceX), isIntoX);
+                cx = _mm256_blendv_ps(cx, surfaceX, isClipX);
+                vx = _mm256_blendv_ps(vx, bouncedX, isClipX);
+
+                const __m256 surfaceY = _mm256_blendv_ps(_mm256_sub_ps(boxY, sumY), _mm256_add_ps(boxY, sumY), isBelow);
+                const __m256 clippedY = _mm256_blendv_ps(_mm256_min_ps(vy, zero), _mm256_max_ps(vy, zero), isBelow);
+                cy = _mm256_blendv_ps(cy, surfaceY, isClipY);
+                vy = _mm256_blendv_ps(vy, clippedY, isClipY);
+            }
+        }
+
+        _mm256_store_ps(&bodies->x[i], cx);
+        _mm256_store_ps(&bodies->y[i], _mm256_add_ps(cy, height));
+        _mm256_store_ps(&bodies->velocityX[i], vx);
+        _mm256_store_ps(&bodies->velocityY[i], vy);
+    }
+    return end;
+}
+
+static bool isAvx2Supported() {
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 1);
+    // The OS has to save the YMM registers (OSXSAVE and AVX bits, then XCR0)
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // BODIES_X64
+
+void bodiesInit(Bodies* bodies, int capacity, Vector2 size) {
+    *bodies = {};
+    // Whole batches, so every array starts aligned
+    bodies->capacity = (capacity + BODIES_BATCH_SIZE - 1) / BODIES_BATCH_SIZE * BODIES_BATCH_SIZE;
+    // Bigger bodies could overlap more than 2x2 tiles
+    bodies->size = { fminf(size.x, 0.49f), fminf(size.y, 0.49f) };
+
+    const size_t arraySize = sizeof(float) * (bodies->capacity > 0 ? bodies->capacity : BODIES_BATCH_SIZE);
+    uint8_t* memory = (uint8_t*)malloc(arraySize * 4 + BODIES_ALIGNMENT);
+    bodies->memory = memory;
+    memory += (BODIES_ALIGNMENT - (uintptr_t)memory % BODIES_ALIGNMENT) % BODIES_ALIGNMENT;
+    bodies->x = (float*)(memory + arraySize * 0);
+    bodies->y = (float*)(memory + arraySize * 1);
+    bodies->velocityX = (float*)(memory + arraySize * 2);
+    bodies->velocityY = (float*)(memory + arraySize * 3);
+}
+
+void bodiesFree(Bodies* bodies) {
+    free(bodies->memory);
+    *bodies = {};
+}
+
+int bodiesAdd(Bodies* bodies, Vector2 position, Vector2 velocity) {
+    if (bodies->count >= bodies->capacity) return -1;
+
+    const int index = bodies->count++;
+    bodies->x[index] = position.x;
+    bodies->y[index] = position.y;
+    bodies->velocityX[index] = velocity.x;
+    bodies->velocityY[index] = velocity.y;
+    return index;
+}
+
+void bodiesRemove(Bodies* bodies, int index) {
+    if (index < 0 || index >= bodies->count) return;
+
+    const int last = --bodies->count;
+    bodies->x[index] = bodies->x[last];
+    bodies->y[index] = bodies->y[last];
+    bodies->velocityX[index] = bodies->velocityX[last];
+    bodies->velocityY[index] = bodies->velocityY[last];
+}
+
+BodiesSimd bodiesGetBestSimd() {
+#ifdef BODIES_X64
+    static const bool isAvx2 = isAvx2Supported();
+    return isAvx2 ? BODIES_SIMD_AVX2 : BODIES_SIMD_SSE2;
+#else
+    return BODIES_SIMD_SCALAR;
+#endif
+}
+
+void bodiesResolveCollisionsWith(Bodies* bodies, const CollisionMask* mask, float tilemapHeight, int screenIndex, BodiesSimd simd) {
+    TRACE_SCOPE("bodiesResolveCollisions");
+    if (simd > bodiesGetBestSimd()) simd = BODIES_SIMD_SCALAR;
+
+    int numResolved = 0;
+#ifdef BODIES_X64
+    if (simd != BODIES_SIMD_SCALAR) {
+        ScreenTables tables;
+        buildScreenTables(&tables, mask, screenIndex);
+        numResolved = simd == BODIES_SIMD_AVX2 ? resolveAvx2(bodies, &tables, tilemapHeight) : resolveSse2(bodies, &tables, tilemapHeight);
+    }
+#else
+    (void)screenIndex;
+#endif
+    resolveScalar(bodies, mask, tilemapHeight, numResolved);
+}
+
+void bodiesResolveCollisions(Bodies* bodies, const CollisionMask* mask, float tilemapHeight, int screenIndex) {
+    bodiesResolveCollisionsWith(bodies, mask, tilemapHeight, screenIndex, bodiesGetBestSimd());
+}
+
+void bodiesStep(Bodies* bodies, const CollisionMask* mask, float tilemapHeight, int screenIndex, float delta) {
+    // Plain loops over the arrays, the compiler vectorizes these on its own
+    for (int i = 0; i < bodies->count; i++) bodies->velocityY[i] += PLAYER_GRAVITY * delta;
+    for (int i = 0; i < bodies->count; i++) bodies->x[i] += bodies->velocityX[i] * delta;
+    for (int i = 0; i < bodies->count; i++) bodies->y[i] += bodies->velocityY[i] * delta;
+
+    bodiesResolveCollisions(bodies, mask, tilemapHeight, screenIndex);
+}
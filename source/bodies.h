@@ -0,0 +1,59 @@
+// Bodies
+// ------
+// Many simple boxes moving through the level at once (ghosts, agents, debris), stored as a structure of arrays:
+// every property has its own array, so a batch of bodies fills a SIMD register with a single load.
+//
+// `bodiesResolveCollisions` is the batched `resolveBoxCollisionWithTilemap`: 8 bodies per instruction with AVX2,
+// 4 with SSE2 (picked at runtime), and a scalar fallback on other CPUs. All of them give exactly the same result
+// as calling `resolveBoxCollisionWithTilemap` on every body.
+//
+// A batch is resolved against a single screen: the tiles of the screen (and a few rows around it) are copied
+// into small tables first, so the tile lookups of all bodies are gathers from the same few cache lines.
+// The center of every body has to be on that screen, or at most one row above or below it.
+// All bodies of a store have the same size, smaller than a tile (they overlap at most 2x2 tiles).
+#pragma once
+
+#include "sim.h"
+
+// Bodies are processed in batches of this many, the arrays are padded to it
+#define BODIES_BATCH_SIZE 8
+
+struct Bodies {
+    // Position (center of the box) and velocity, `count` of them
+    float* x;
+    float* y;
+    float* velocityX;
+    float* velocityY;
+    int count;
+    int capacity;
+    // Half-size of every body's box, smaller than 0.5 on both axes
+    Vector2 size;
+    // Single allocation behind all of the arrays
+    void* memory;
+};
+
+enum BodiesSimd {
+    BODIES_SIMD_SCALAR,
+    BODIES_SIMD_SSE2,
+    BODIES_SIMD_AVX2,
+};
+
+void bodiesInit(Bodies* bodies, int capacity, Vector2 size);
+void bodiesFree(Bodies* bodies);
+// Returns the index of the new body, or -1 if the store is full.
+int bodiesAdd(Bodies* bodies, Vector2 position, Vector2 velocity);
+// Removes the body by moving the last one into its place (indices of other bodies can change).
+void bodiesRemove(Bodies* bodies, int index);
+
+// Best instruction set this CPU supports.
+BodiesSimd bodiesGetBestSimd();
+
+// Push every body out of the tiles of the screen and clip (or bounce) its velocity,
+// the same way `resolveBoxCollisionWithTilemap` does.
+void bodiesResolveCollisions(Bodies* bodies, const CollisionMask* mask, float tilemapHeight, int screenIndex);
+// Same, with a specific instruction set (e.g. for comparing them). Falls back to scalar if the CPU doesn't support it.
+void bodiesResolveCollisionsWith(Bodies* bodies, const CollisionMask* mask, float tilemapHeight, int screenIndex, BodiesSimd simd);
+
+// Gravity, movement by `velocity * delta` and `bodiesResolveCollisions`.
+// Bodies aren't swept, so they have to be slower than `size / delta` to not pass through thin walls.
+void bodiesStep(Bodies* bodies, const CollisionMask* mask, float tilemapHeight, int screenIndex, float delta);
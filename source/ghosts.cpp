@@ -0,0 +1,214 @@
+#include "ghosts.h"
+#include "trace.h"
+#include <math.h> // floor
+#include <stdlib.h> // realloc, free
+#include <string.h> // memcpy
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Track of a single replay, before it's added to `Ghosts`
+struct BakedTrack {
+    std::vector<GhostKeyframe> keyframes;
+    int32_t startY;
+    bool isLoaded;
+};
+
+// Replays shared by the baking threads, every thread takes the next one which wasn't taken yet
+struct BakeJob {
+    // Files to load into `replays` first, NULL if the replays are loaded already
+    const char* const* paths;
+    Replay* replays;
+    int numReplays;
+    const World* world;
+    BakedTrack* tracks;
+    std::atomic<int> nextReplay;
+};
+
+static int32_t toFixed(float value) {
+    return (int32_t)floor((double)value * GHOST_POSITION_SCALE + 0.5);
+}
+
+static int16_t clampToInt16(int32_t value) {
+    return (int16_t)(value < INT16_MIN ? INT16_MIN : (value > INT16_MAX ? INT16_MAX : value));
+}
+
+static void addKeyframe(BakedTrack* track, int32_t* y, const Player* player) {
+    GhostKeyframe keyframe = {};
+    keyframe.x = clampToInt16(toFixed(player->position.x));
+    // Relative to where the track actually is, so a clamped delta (a teleport) gets caught up with later
+    keyframe.deltaY = track->keyframes.empty() ? 0 : clampToInt16(toFixed(player->position.y) - *y);
+    keyframe.sprite = (uint8_t)(getPlayerSprite(player) | (player->isFacingRight ? 0 : GHOST_SPRITE_FLIPPED));
+    *y += keyframe.deltaY;
+    track->keyframes.push_back(keyframe);
+}
+
+static void bakeTrack(BakedTrack* track, const Replay* replay, const World* world) {
+    SimState state = {};
+    simInit(&state, world);
+    track->startY = toFixed(state.player.position.y);
+    track->keyframes.reserve((size_t)(replay->numTicks / GHOST_KEYFRAME_TICKS + 1));
+
+    int32_t y = track->startY;
+    addKeyframe(track, &y, &state.player);
+    for (int i = 0; i < replay->numRuns; i++) {
+        const ReplayRun run = replay->runs[i];
+        for (int t = 0; t < run.count; t++) {
+            simStep(&state, run.input, run.delta);
+            // The game advances the animation once per frame, per tick is close enough for ghosts
+            state.player.animTime += run.delta;
+            if (state.tick % GHOST_KEYFRAME_TICKS == 0) addKeyframe(track, &y, &state.player);
+        }
+    }
+}
+
+static void appendTrack(Ghosts* ghosts, const BakedTrack* baked) {
+    const int numKeyframes = (int)baked->keyframes.size();
+    ghosts->keyframes = (GhostKeyframe*)realloc(ghosts->keyframes, sizeof(GhostKeyframe) * (ghosts->numKeyframes + numKeyframes));
+    memcpy(&ghosts->keyframes[ghosts->numKeyframes], baked->keyframes.data(), sizeof(GhostKeyframe) * numKeyframes);
+
+    const int index = ghosts->count++;
+    ghosts->tracks = (GhostTrack*)realloc(ghosts->tracks, sizeof(GhostTrack) * ghosts->count);
+    ghosts->positions = (Vector2*)realloc(ghosts->positions, sizeof(Vector2) * ghosts->count);
+    ghosts->sprites = (uint8_t*)realloc(ghosts->sprites, sizeof(uint8_t) * ghosts->count);
+
+    GhostTrack* track = &ghosts->tracks[index];
+    *track = {};
+    track->firstKeyframe = ghosts->numKeyframes;
+    track->numKeyframes = numKeyframes;
+    track->startY = baked->startY;
+    track->y = baked->startY;
+    ghosts->positions[index] = { (float)baked->keyframes[0].x / GHOST_POSITION_SCALE, (float)baked->startY / GHOST_POSITION_SCALE };
+    ghosts->sprites[index] = baked->keyframes[0].sprite;
+
+    ghosts->numKeyframes += numKeyframes;
+}
+
+// The replay of the track which was appended last
+static void appendReplay(Ghosts* ghosts, const Replay* replay) {
+    ghosts->replays = (Replay*)realloc(ghosts->replays, sizeof(Replay) * ghosts->count);
+    ghosts->replays[ghosts->count - 1] = *replay;
+}
+
+static void runBakeWorker(BakeJob* job) {
+    for (int i = job->nextReplay++; i < job->numReplays; i = job->nextReplay++) {
+        if (job->paths && !replayLoad(&job->replays[i], job->paths[i])) continue;
+
+        bakeTrack(&job->tracks[i], &job->replays[i], job->world);
+        job->tracks[i].isLoaded = true;
+    }
+}
+
+static void runBakeJob(BakeJob* job) {
+    int numThreads = (int)std::thread::hardware_concurrency();
+    if (numThreads > job->numReplays) numThreads = job->numReplays;
+    if (numThreads < 1) numThreads = 1;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) threads.push_back(std::thread(runBakeWorker, job));
+    for (std::thread& thread : threads) thread.join();
+}
+
+void ghostsAdd(Ghosts* ghosts, const Replay* replay, const World* world) {
+    BakedTrack track = {};
+    bakeTrack(&track, replay, world);
+    appendTrack(ghosts, &track);
+
+    // Kept for `ghostsRebake`, the caller still owns `replay`
+    Replay copy = *replay;
+    copy.runs = (ReplayRun*)malloc(sizeof(ReplayRun) * (replay->numRuns > 0 ? replay->numRuns : 1));
+    memcpy(copy.runs, replay->runs, sizeof(ReplayRun) * replay->numRuns);
+    appendReplay(ghosts, &copy);
+}
+
+int ghostsLoad(Ghosts* ghosts, const char* const* paths, int numPaths, const World* world) {
+    if (numPaths <= 0) return 0;
+
+    std::vector<Replay> replays(numPaths);
+    std::vector<BakedTrack> tracks(numPaths);
+    BakeJob job;
+    job.paths = paths;
+    job.replays = replays.data();
+    job.numReplays = numPaths;
+    job.world = world;
+    job.tracks = tracks.data();
+    job.nextReplay = 0;
+    runBakeJob(&job);
+
+    // Added in the order of the paths, no matter which thread finished first
+    int numAdded = 0;
+    for (int i = 0; i < numPaths; i++) {
+        if (!tracks[i].isLoaded) continue;
+        appendTrack(ghosts, &tracks[i]);
+        appendReplay(ghosts, &replays[i]);
+        numAdded++;
+    }
+    return numAdded;
+}
+
+void ghostsRebake(Ghosts* ghosts, const World* world) {
+    if (ghosts->count <= 0) return;
+
+    const int numReplays = ghosts->count;
+    std::vector<BakedTrack> tracks(numReplays);
+    BakeJob job;
+    job.paths = NULL;
+    job.replays = ghosts->replays;
+    job.numReplays = numReplays;
+    job.world = world;
+    job.tracks = tracks.data();
+    job.nextReplay = 0;
+    runBakeJob(&job);
+
+    // Appended again from the start, the replays stay where they are
+    ghosts->numKeyframes = 0;
+    ghosts->count = 0;
+    for (const BakedTrack& track : tracks) appendTrack(ghosts, &track);
+}
+
+void ghostsFree(Ghosts* ghosts) {
+    for (int i = 0; i < ghosts->count; i++) replayFree(&ghosts->replays[i]);
+    free(ghosts->replays);
+    free(ghosts->keyframes);
+    free(ghosts->tracks);
+    free(ghosts->positions);
+    free(ghosts->sprites);
+    *ghosts = {};
+}
+
+void ghostsUpdate(Ghosts* ghosts, uint64_t tick, float tickFraction) {
+    TRACE_SCOPE("ghostsUpdate");
+    const uint64_t targetKeyframe = tick / GHOST_KEYFRAME_TICKS;
+    const float blend = ((float)(tick % GHOST_KEYFRAME_TICKS) + tickFraction) / GHOST_KEYFRAME_TICKS;
+    const float scale = 1.0f / GHOST_POSITION_SCALE;
+
+    for (int i = 0; i < ghosts->count; i++) {
+        GhostTrack* track = &ghosts->tracks[i];
+        const GhostKeyframe* keyframes = &ghosts->keyframes[track->firstKeyframe];
+        const int lastKeyframe = track->numKeyframes - 1;
+        const int target = targetKeyframe < (uint64_t)lastKeyframe ? (int)targetKeyframe : lastKeyframe;
+
+        // Y is stored as deltas, so the cursor has to walk over every keyframe
+        if (target < track->keyframe) {
+            track->keyframe = 0;
+            track->y = track->startY;
+        }
+        while (track->keyframe < target) {
+            track->keyframe++;
+            track->y += keyframes[track->keyframe].deltaY;
+        }
+
+        const GhostKeyframe* current = &keyframes[track->keyframe];
+        Vector2 position = { (float)current->x * scale, (float)track->y * scale };
+        if (track->keyframe < lastKeyframe) {
+            const GhostKeyframe* next = current + 1;
+            position.x += (float)(next->x - current->x) * scale * blend;
+            position.y += (float)next->deltaY * scale * blend;
+        }
+        ghosts->positions[i] = position;
+        ghosts->sprites[i] = current->sprite;
+    }
+}
+
+size_t ghostsGetMemorySize(const Ghosts* ghosts) {
+    return sizeof(GhostKeyframe) * ghosts->numKeyframes + sizeof(GhostTrack) * ghosts->count;
+}
@@ -0,0 +1,70 @@
+// Ghosts
+// ------
+// Recorded runs (replays, see `replay.h`) shown as translucent players next to the live one, to race against.
+//
+// Re-simulating thousands of replays every frame would cost more than the rest of the game, so every replay is
+// simulated once when it's loaded and baked into a track: the player's position and sprite every GHOST_KEYFRAME_TICKS ticks.
+// The replays are kept, so the tracks can be baked again when the level changes (`ghostsRebake`).
+// Keyframes are 6 bytes (fixed-point X, change of Y since the previous keyframe, sprite), so a one minute run is about 21 kB.
+// Every ghost keeps a cursor into its track, which only moves forward while the race goes on, so `ghostsUpdate`
+// is a couple of loads and a lerp per ghost. The results are in flat arrays, ready to go into a single `SpriteBatch`.
+#pragma once
+
+#include "replay.h"
+#include <stddef.h> // size_t
+
+// Ticks between two keyframes of a track, positions between them are interpolated
+#define GHOST_KEYFRAME_TICKS 2
+// Keyframe positions are in 1/GHOST_POSITION_SCALE tiles
+#define GHOST_POSITION_SCALE 256
+// Set in a ghost's sprite if it faces left (the rest is the sprite, see `getPlayerSprite`)
+#define GHOST_SPRITE_FLIPPED 0x80
+
+struct GhostKeyframe {
+    int16_t x;
+    // Relative to the previous keyframe, so tracks anywhere in tall levels fit into 16 bits
+    int16_t deltaY;
+    uint8_t sprite;
+};
+
+struct GhostTrack {
+    // Keyframes of the track in `Ghosts::keyframes`
+    int firstKeyframe;
+    int numKeyframes;
+    // Fixed-point Y of the first keyframe
+    int32_t startY;
+
+    // Cursor: current keyframe and its fixed-point Y
+    int keyframe;
+    int32_t y;
+};
+
+struct Ghosts {
+    // Keyframes of all tracks, one track after another
+    GhostKeyframe* keyframes;
+    int numKeyframes;
+    GhostTrack* tracks;
+    // Replay of every track
+    Replay* replays;
+    int count;
+
+    // Where every ghost is, and what it looks like, as of the last `ghostsUpdate`
+    Vector2* positions;
+    uint8_t* sprites;
+};
+
+// Simulate a replay in the `world` (from `simInit`) and add it as a ghost.
+void ghostsAdd(Ghosts* ghosts, const Replay* replay, const World* world);
+// Load replay files and add them as ghosts, in the order of `paths`. They're simulated on all cores.
+// Files that fail to load are skipped, returns the number of ghosts added.
+int ghostsLoad(Ghosts* ghosts, const char* const* paths, int numPaths, const World* world);
+// Simulate every ghost's replay again in the `world`, after the level was changed. Cursors start over.
+void ghostsRebake(Ghosts* ghosts, const World* world);
+void ghostsFree(Ghosts* ghosts);
+
+// Move every ghost to where its run was `tick + tickFraction` ticks after the start.
+// Finished ghosts stay at the end of their run. Fastest when `tick` only grows, going back rewinds the cursors.
+void ghostsUpdate(Ghosts* ghosts, uint64_t tick, float tickFraction);
+
+// Bytes used by the tracks.
+size_t ghostsGetMemorySize(const Ghosts* ghosts);
@@ -0,0 +1,115 @@
+#include "jump_table.h"
+#include <stdio.h>
+#include <stdlib.h> // calloc, free
+#include <string.h> // memcmp
+
+#define JUMP_TABLE_HEADER_WORDS 5
+
+uint32_t jumpTableHashLevel(const World* world) {
+    uint32_t hash = 2166136261u;
+    for (int y = 0; y < world->numRows; y++) {
+        const uint8_t* row = &world->tiles[(size_t)y * world->rowStride];
+        for (int x = 0; x < TILEMAP_SIZE_X; x++) {
+            hash = (hash ^ row[x]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+void jumpTableInit(JumpTable* table, const World* world) {
+    table->numScreens = world->numScreens;
+    table->levelHash = jumpTableHashLevel(world);
+    table->entries = (JumpTableEntry*)calloc(
+        (size_t)JUMP_TABLE_SCREEN_ENTRIES * (world->numScreens > 0 ? world->numScreens : 1), sizeof(JumpTableEntry));
+}
+
+void jumpTableFree(JumpTable* table) {
+    free(table->entries);
+    *table = {};
+}
+
+void jumpTableBuildScreen(JumpTable* table, const World* world, int screenIndex) {
+    if (screenIndex < 0 || screenIndex >= table->numScreens) return;
+
+    const int screenRow = screenIndex * TILEMAP_SIZE_Y;
+    for (int y = screenRow; y < screenRow + TILEMAP_SIZE_Y; y++) {
+        for (int x = 0; x < TILEMAP_SIZE_X; x++) {
+            const StandingTile start = { x, y };
+            const bool isStanding = isStandingTile(world, x, y);
+
+            for (int charge = 0; charge < JUMP_CHARGE_BUCKETS; charge++) {
+                for (int dir = 0; dir < JUMP_DIRECTION_COUNT; dir++) {
+                    JumpTableEntry* entry = &table->entries[jumpTableGetEntryIndex(start, charge, (JumpDirection)dir)];
+                    *entry = {};
+                    if (!isStanding) continue;
+
+                    const JumpResult result = simulateJump(world, start, JUMP_START_OFFSETS / 2, charge, (JumpDirection)dir);
+                    if (!result.isLanded) continue;
+                    entry->landingX = (int8_t)result.landing.x;
+                    entry->landingY = (int32_t)result.landing.y;
+                    entry->numTicks = (uint16_t)(result.numTicks < UINT16_MAX ? result.numTicks : UINT16_MAX);
+                    entry->isLanded = 1;
+                }
+            }
+        }
+    }
+}
+
+bool jumpTableSave(const JumpTable* table, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    const uint32_t header[JUMP_TABLE_HEADER_WORDS] = {
+        JUMP_TABLE_VERSION, (uint32_t)table->numScreens, table->levelHash, JUMP_CHARGE_BUCKETS, JUMP_DIRECTION_COUNT,
+    };
+    const size_t numEntries = (size_t)JUMP_TABLE_SCREEN_ENTRIES * table->numScreens;
+    bool isOk = fwrite(JUMP_TABLE_MAGIC, 4, 1, file) == 1;
+    isOk = isOk && fwrite(header, sizeof(header), 1, file) == 1;
+    isOk = isOk && fwrite(table->entries, sizeof(JumpTableEntry), numEntries, file) == numEntries;
+    // Buffered data is only written out here, so a full disk shows up as a failed close
+    isOk = fclose(file) == 0 && isOk;
+    return isOk;
+}
+
+bool jumpTableLoad(JumpTable* table, const char* path, const World* world) {
+    *table = {};
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    char magic[4] = {};
+    uint32_t header[JUMP_TABLE_HEADER_WORDS] = {};
+    if (fread(magic, 4, 1, file) != 1 || fread(header, sizeof(header), 1, file) != 1 ||
+        memcmp(magic, JUMP_TABLE_MAGIC, 4) != 0 || header[0] != JUMP_TABLE_VERSION ||
+        header[3] != JUMP_CHARGE_BUCKETS || header[4] != JUMP_DIRECTION_COUNT) {
+        fclose(file);
+        return false;
+    }
+
+    // Made for another level
+    if (header[1] != (uint32_t)world->numScreens || header[2] != jumpTableHashLevel(world)) {
+        fclose(file);
+        return false;
+    }
+
+    const int numScreens = (int)header[1];
+    const size_t numEntries = (size_t)JUMP_TABLE_SCREEN_ENTRIES * numScreens;
+    JumpTableEntry* entries = (JumpTableEntry*)calloc(numEntries > 0 ? numEntries : 1, sizeof(JumpTableEntry));
+    const size_t numRead = fread(entries, sizeof(JumpTableEntry), numEntries, file);
+    fclose(file);
+
+    if (numRead != numEntries) {
+        free(entries);
+        return false;
+    }
+
+    table->entries = entries;
+    table->numScreens = numScreens;
+    table->levelHash = header[2];
+    return true;
+}
+
+const JumpTableEntry* jumpTableGetScreen(const JumpTable* table, int screenIndex) {
+    if (screenIndex < 0 || screenIndex >= table->numScreens) return NULL;
+    return &table->entries[(size_t)screenIndex * JUMP_TABLE_SCREEN_ENTRIES];
+}
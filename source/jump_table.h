@@ -0,0 +1,80 @@
+// Jump landing table
+// ------------------
+// Where every jump lands, precomputed for every standing tile of the level.
+// Jumps are deterministic, so instead of simulating hundreds of ticks (`simulateJump`)
+// solvers, hints and AI agents can answer "where does this jump land" with a single lookup.
+//
+// The table is built offline (see tools/jump_table.cpp) and stored per screen.
+// Jumps start in the middle of the tile and use the charge buckets from "jumps.h".
+//
+// File layout (little-endian):
+//  header:  magic "JPJT" (4 bytes), version (u32), number of screens (u32), level hash (u32), charge buckets (u32), directions (u32)
+//  entries: landing y (i32), landing x (i8), is landed (u8), ticks (u16) ... for every entry
+//
+// The level hash is taken over all tiles (`jumpTableHashLevel`), a table is only loaded for the level it was built from.
+#pragma once
+
+#include "jumps.h"
+
+#define JUMP_TABLE_MAGIC "JPJT"
+#define JUMP_TABLE_VERSION 2u
+
+// Number of entries of a single standing tile (every charge bucket in every direction).
+#define JUMP_TABLE_TILE_ENTRIES (JUMP_CHARGE_BUCKETS * JUMP_DIRECTION_COUNT)
+// Number of entries of a single screen (every tile, even the ones you can't stand on).
+#define JUMP_TABLE_SCREEN_ENTRIES (TILEMAP_SIZE_Y * TILEMAP_SIZE_X * JUMP_TABLE_TILE_ENTRIES)
+
+// Compact `JumpResult`.
+struct JumpTableEntry {
+    // Tile of the world grid the jump lands on (can be on another screen).
+    // Rows are 32 bits, level packs can have way more rows than fit into 16.
+    int32_t landingY;
+    int8_t landingX;
+    // False if the jump never lands, or the tile isn't a standing tile.
+    uint8_t isLanded;
+    // Ticks from the start of charging until landing
+    uint16_t numTicks;
+};
+
+static_assert(sizeof(JumpTableEntry) == 8, "JumpTableEntry is stored in files as is");
+
+// Entries for all screens, `JUMP_TABLE_SCREEN_ENTRIES` per screen.
+// Inside of a screen they are ordered by row, column, charge bucket and direction.
+struct JumpTable {
+    JumpTableEntry* entries;
+    int numScreens;
+    // `jumpTableHashLevel` of the level the table was made for
+    uint32_t levelHash;
+};
+
+// Hash of all tiles of the world (FNV-1a).
+uint32_t jumpTableHashLevel(const World* world);
+
+// Allocate an empty table (nothing lands) for every screen of the world.
+void jumpTableInit(JumpTable* table, const World* world);
+void jumpTableFree(JumpTable* table);
+// Simulate every jump from every standing tile of a screen.
+// Different screens can be built from different threads at the same time.
+void jumpTableBuildScreen(JumpTable* table, const World* world, int screenIndex);
+
+bool jumpTableSave(const JumpTable* table, const char* path);
+// Fails if the file was built with different settings (e.g. another number of charge buckets)
+// or for another level than `world`.
+bool jumpTableLoad(JumpTable* table, const char* path, const World* world);
+
+// Entries of a screen, or NULL if it's outside of the table.
+const JumpTableEntry* jumpTableGetScreen(const JumpTable* table, int screenIndex);
+
+// Index into `JumpTable::entries` (doesn't check the bounds).
+// In `size_t`, tables of big level packs have more entries than fit into an `int`.
+inline size_t jumpTableGetEntryIndex(StandingTile start, int chargeBucket, JumpDirection direction) {
+    const size_t tileIndex = (size_t)start.y * TILEMAP_SIZE_X + (size_t)start.x;
+    return tileIndex * JUMP_TABLE_TILE_ENTRIES + (size_t)(chargeBucket * JUMP_DIRECTION_COUNT + direction);
+}
+
+// Where a jump from the `start` tile (world grid) lands, or NULL if it's outside of the table.
+inline const JumpTableEntry* jumpTableLookup(const JumpTable* table, StandingTile start, int chargeBucket, JumpDirection direction) {
+    if (start.x < 0 || start.x >= TILEMAP_SIZE_X || start.y < 0 || start.y >= table->numScreens * TILEMAP_SIZE_Y) return NULL;
+    if (chargeBucket < 0 || chargeBucket >= JUMP_CHARGE_BUCKETS || (unsigned)direction >= JUMP_DIRECTION_COUNT) return NULL;
+    return &table->entries[jumpTableGetEntryIndex(start, chargeBucket, direction)];
+}
@@ -0,0 +1,102 @@
+#include "jumps.h"
+
+// Input bits for holding a direction
+static Input getDirectionInput(JumpDirection direction) {
+    if (direction == JUMP_LEFT) return INPUT_LEFT;
+    if (direction == JUMP_RIGHT) return INPUT_RIGHT;
+    return 0;
+}
+
+bool isStandingTile(const World* world, int x, int y) {
+    return !worldIsTileFull(world, x, y) && worldIsTileFull(world, x, y + 1);
+}
+
+Vector2 getStandingPosition(const World* world, StandingTile tile, int startOffset) {
+    // Spread between the box touching the left edge and touching the right edge of the tile
+    const float minX = PLAYER_SIZE.x;
+    const float maxX = 1.0f - PLAYER_SIZE.x;
+    const float t = JUMP_START_OFFSETS > 1 ? (float)startOffset / (float)(JUMP_START_OFFSETS - 1) : 0.5f;
+    return { (float)tile.x + minX + (maxX - minX) * t, world->topY + (float)(tile.y + 1) - PLAYER_SIZE.y };
+}
+
+int getJumpChargeTicks(int chargeBucket) {
+    // Mirrors `Clamp(jumpHoldTime * 2.6f, 1.1f, 2.0f)` in `updatePlayer`,
+    // holding for less or more than this doesn't change anything.
+    const int minTicks = (int)ceilf(1.1f / 2.6f * SIM_TICK_RATE);
+    const int maxTicks = (int)ceilf(2.0f / 2.6f * SIM_TICK_RATE);
+    return minTicks + (maxTicks - minTicks) * chargeBucket / (JUMP_CHARGE_BUCKETS - 1);
+}
+
+// Put the player at the tile and step the simulation until they are standing still.
+static bool startStanding(SimState* state, const World* world, StandingTile tile, int startOffset) {
+    simInit(state, world);
+    state->player.position = getStandingPosition(world, tile, startOffset);
+    for (int i = 0; i < 4; i++) {
+        simStep(state, 0, SIM_TICK_DELTA);
+    }
+    return state->player.isOnGround;
+}
+
+// Step with no input until the player lands.
+static JumpResult finishLanding(SimState* state, const World* world, int numTicks) {
+    JumpResult result = {};
+    const float bottomY = world->topY + (float)world->numRows;
+
+    for (int i = 0; i < JUMP_MAX_TICKS; i++) {
+        simStep(state, 0, SIM_TICK_DELTA);
+        numTicks++;
+
+        const Player* player = &state->player;
+        if (player->position.y > bottomY + TILEMAP_SIZE_Y) return result;
+
+        // `isOnGround` is updated before the movement, so wait one more tick for the velocity to settle
+        if (player->isOnGround && player->velocity.y == 0.0f && i > 0) {
+            result.isLanded = true;
+            result.landing.x = (int)floorf(player->position.x);
+            result.landing.y = worldGetRowAtHeight(world, player->position.y);
+            result.numTicks = numTicks;
+            return result;
+        }
+    }
+
+    return result;
+}
+
+JumpResult simulateJump(const World* world, StandingTile start, int startOffset, int chargeBucket, JumpDirection direction) {
+    SimState state = {};
+    if (!startStanding(&state, world, start, startOffset)) return JumpResult{};
+
+    const Input dirInput = getDirectionInput(direction);
+    const int chargeTicks = getJumpChargeTicks(chargeBucket);
+    for (int i = 0; i < chargeTicks; i++) {
+        simStep(&state, INPUT_JUMP | dirInput, SIM_TICK_DELTA);
+    }
+    // Release the jump key, the direction decides where we jump
+    simStep(&state, dirInput, SIM_TICK_DELTA);
+
+    return finishLanding(&state, world, chargeTicks + 1);
+}
+
+JumpResult simulateWalk(const World* world, StandingTile start, JumpDirection direction) {
+    SimState state = {};
+    if (direction == JUMP_UP || !startStanding(&state, world, start, JUMP_START_OFFSETS / 2)) return JumpResult{};
+
+    const Input dirInput = getDirectionInput(direction);
+    int numTicks = 0;
+    while (numTicks < JUMP_MAX_TICKS && (int)floorf(state.player.position.x) == start.x && state.player.isOnGround) {
+        const float prevX = state.player.position.x;
+        simStep(&state, dirInput, SIM_TICK_DELTA);
+        numTicks++;
+        // Walking into a wall
+        if (state.player.position.x == prevX && state.player.isOnGround) return JumpResult{};
+    }
+    // Walk to the middle of the new tile, unless we're already falling
+    const float targetX = floorf(state.player.position.x) + 0.5f;
+    while (numTicks < JUMP_MAX_TICKS && state.player.isOnGround &&
+        (direction == JUMP_RIGHT ? state.player.position.x < targetX : state.player.position.x > targetX)) {
+        simStep(&state, dirInput, SIM_TICK_DELTA);
+        numTicks++;
+    }
+
+    return finishLanding(&state, world, numTicks);
+}
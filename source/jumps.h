@@ -0,0 +1,45 @@
+// Jump simulation helpers
+// -----------------------
+// Runs the real simulation (`simStep`) for the discrete actions a player can take while standing:
+// walking one tile left or right, or a jump with a given charge and direction.
+// Used by offline tools (reachability solver, jump tables) which search over these actions.
+#pragma once
+
+#include "sim.h"
+
+// Number of distinct jump charges we try, spread evenly between the weakest and the strongest jump.
+#define JUMP_CHARGE_BUCKETS 16
+// Number of places inside a standing tile we start actions from.
+// The middle alone misses jumps which only work from the very edge of a platform.
+#define JUMP_START_OFFSETS 3
+// Give up on a jump or walk if the player didn't land after this many ticks.
+#define JUMP_MAX_TICKS (SIM_TICK_RATE * 10)
+
+enum JumpDirection { JUMP_LEFT, JUMP_UP, JUMP_RIGHT, JUMP_DIRECTION_COUNT };
+
+// Where the player can stand: an empty tile with a full tile below it.
+// `y` is the row of the world grid the player is in (not the floor).
+struct StandingTile {
+    int x;
+    int y;
+};
+
+// Where an action ended.
+struct JumpResult {
+    // False if the player fell out of the world or didn't land in time.
+    bool isLanded;
+    StandingTile landing;
+    // Ticks from the start of the action until landing (including charging the jump).
+    int numTicks;
+};
+
+bool isStandingTile(const World* world, int x, int y);
+// World-space position of the player standing in the tile, `startOffset` goes from the left
+// edge to the right edge of the tile (0 to JUMP_START_OFFSETS - 1), the middle one is in the middle.
+Vector2 getStandingPosition(const World* world, StandingTile tile, int startOffset);
+// How many ticks the jump key is held for a charge bucket.
+int getJumpChargeTicks(int chargeBucket);
+
+JumpResult simulateJump(const World* world, StandingTile start, int startOffset, int chargeBucket, JumpDirection direction);
+// Walk until the player gets to the next tile (or falls off an edge) and let them land.
+JumpResult simulateWalk(const World* world, StandingTile start, JumpDirection direction);
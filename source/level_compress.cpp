@@ -0,0 +1,192 @@
+#include "level_compress.h"
+#include "level_file.h"
+#include <stdio.h>
+#include <stdlib.h> // malloc, calloc, free
+#include <string.h> // memcmp, memcpy
+#include <string>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h> // MoveFileExA
+#endif
+
+// Rows of the decoded level file image, past this the offsets in `LevelFileHeader` would overflow
+#define MAX_DECOMPRESSED_ROWS ((UINT32_MAX - sizeof(LevelFileHeader)) / (TILEMAP_SIZE_X + sizeof(uint16_t)))
+
+static uint64_t getIndicesSize(uint64_t numRows, uint32_t bitsPerIndex) {
+    return (numRows * bitsPerIndex + 7) / 8 + LEVEL_COMPRESS_PADDING;
+}
+
+// Everything the header promises has to be inside of the data, so decoding can't read past it.
+static bool isHeaderValid(const CompressedLevelHeader* header, size_t size) {
+    if (memcmp(header->magic, LEVEL_COMPRESS_MAGIC, 4) != 0 || header->version != LEVEL_COMPRESS_VERSION) return false;
+    if (header->screenSizeX != TILEMAP_SIZE_X || header->screenSizeY != TILEMAP_SIZE_Y) return false;
+    if (header->numScreens == 0 || header->numDictionaryRows == 0) return false;
+    if (header->bitsPerIndex > LEVEL_COMPRESS_MAX_INDEX_BITS) return false;
+
+    const uint64_t numRows = (uint64_t)header->numScreens * TILEMAP_SIZE_Y;
+    if (numRows > MAX_DECOMPRESSED_ROWS) return false;
+
+    const uint64_t dictionaryEnd = sizeof(CompressedLevelHeader) + (uint64_t)header->numDictionaryRows * TILEMAP_SIZE_X;
+    const uint64_t indicesEnd = header->indicesOffset + getIndicesSize(numRows, header->bitsPerIndex);
+    return dictionaryEnd <= header->indicesOffset && indicesEnd <= size;
+}
+
+bool levelIsCompressed(const uint8_t* data, size_t size) {
+    return size >= sizeof(CompressedLevelHeader) && memcmp(data, LEVEL_COMPRESS_MAGIC, 4) == 0;
+}
+
+size_t levelGetDecompressedSize(const uint8_t* data, size_t size) {
+    if (size < sizeof(CompressedLevelHeader)) return 0;
+
+    CompressedLevelHeader header = {};
+    memcpy(&header, data, sizeof(header));
+    if (!isHeaderValid(&header, size)) return 0;
+
+    const size_t numRows = (size_t)header.numScreens * TILEMAP_SIZE_Y;
+    return sizeof(LevelFileHeader) + numRows * TILEMAP_SIZE_X + numRows * sizeof(uint16_t);
+}
+
+bool levelDecompress(const uint8_t* data, size_t size, uint8_t* outImage, size_t outSize) {
+    if (outSize == 0 || levelGetDecompressedSize(data, size) != outSize) return false;
+
+    CompressedLevelHeader header = {};
+    memcpy(&header, data, sizeof(header));
+    const int numRows = (int)header.numScreens * TILEMAP_SIZE_Y;
+    const int numDictionaryRows = (int)header.numDictionaryRows;
+    const uint8_t* dictionary = data + sizeof(CompressedLevelHeader);
+    const uint8_t* indices = data + header.indicesOffset;
+
+    // Same layout `levelFileWrite` uses: rows without terminators, mask right after them
+    LevelFileHeader imageHeader = {};
+    memcpy(imageHeader.magic, LEVEL_FILE_MAGIC, 4);
+    imageHeader.version = LEVEL_FILE_VERSION;
+    imageHeader.numScreens = header.numScreens;
+    imageHeader.screenSizeX = TILEMAP_SIZE_X;
+    imageHeader.screenSizeY = TILEMAP_SIZE_Y;
+    imageHeader.rowStride = TILEMAP_SIZE_X;
+    imageHeader.tilesOffset = sizeof(LevelFileHeader);
+    imageHeader.maskOffset = imageHeader.tilesOffset + (uint32_t)numRows * TILEMAP_SIZE_X;
+    memcpy(outImage, &imageHeader, sizeof(imageHeader));
+    uint8_t* tiles = outImage + imageHeader.tilesOffset;
+    uint8_t* maskRows = outImage + imageHeader.maskOffset;
+
+    // The dictionary is a little world of its own, so its mask rows follow the same rules as the level's
+    World dictionaryWorld = {};
+    dictionaryWorld.tiles = dictionary;
+    dictionaryWorld.rowStride = TILEMAP_SIZE_X;
+    dictionaryWorld.numRows = numDictionaryRows;
+    uint16_t* dictionaryMask = (uint16_t*)malloc(sizeof(uint16_t) * numDictionaryRows);
+    for (int i = 0; i < numDictionaryRows; i++) {
+        uint16_t row = 0;
+        for (int x = 0; x < TILEMAP_SIZE_X; x++) {
+            if (worldIsTileFull(&dictionaryWorld, x, i)) row |= (uint16_t)(1u << x);
+        }
+        dictionaryMask[i] = row;
+    }
+
+    const uint64_t indexMask = (1ull << header.bitsPerIndex) - 1ull;
+    uint64_t bitOffset = 0;
+    bool isValid = true;
+    for (int y = 0; y < numRows; y++) {
+        // The padding makes the 8-byte load safe for the last index too
+        uint64_t bits = 0;
+        memcpy(&bits, indices + (bitOffset >> 3), sizeof(bits));
+        const uint32_t index = (uint32_t)((bits >> (bitOffset & 7)) & indexMask);
+        bitOffset += header.bitsPerIndex;
+
+        if (index >= (uint32_t)numDictionaryRows) {
+            isValid = false;
+            break;
+        }
+        memcpy(tiles + (size_t)y * TILEMAP_SIZE_X, dictionary + (size_t)index * TILEMAP_SIZE_X, TILEMAP_SIZE_X);
+        memcpy(maskRows + (size_t)y * sizeof(uint16_t), &dictionaryMask[index], sizeof(uint16_t));
+    }
+
+    free(dictionaryMask);
+    return isValid;
+}
+
+uint8_t* levelCompress(const World* world, size_t* outSize) {
+    // Find the distinct rows, in the order they first show up
+    std::unordered_map<std::string, uint32_t> rowIndices;
+    std::string dictionary;
+    uint32_t* indices = (uint32_t*)malloc(sizeof(uint32_t) * (world->numRows > 0 ? world->numRows : 1));
+    for (int y = 0; y < world->numRows; y++) {
+        const std::string row((const char*)&world->tiles[(size_t)y * world->rowStride], TILEMAP_SIZE_X);
+        auto it = rowIndices.find(row);
+        if (it == rowIndices.end()) {
+            it = rowIndices.emplace(row, (uint32_t)rowIndices.size()).first;
+            dictionary += row;
+        }
+        indices[y] = it->second;
+    }
+
+    const uint32_t numDictionaryRows = (uint32_t)rowIndices.size();
+    uint32_t bitsPerIndex = 0;
+    while ((1ull << bitsPerIndex) < numDictionaryRows) bitsPerIndex++;
+    if (bitsPerIndex > LEVEL_COMPRESS_MAX_INDEX_BITS || world->numRows == 0) {
+        free(indices);
+        return NULL;
+    }
+
+    CompressedLevelHeader header = {};
+    memcpy(header.magic, LEVEL_COMPRESS_MAGIC, 4);
+    header.version = LEVEL_COMPRESS_VERSION;
+    header.numScreens = (uint32_t)world->numScreens;
+    header.screenSizeX = TILEMAP_SIZE_X;
+    header.screenSizeY = TILEMAP_SIZE_Y;
+    header.numDictionaryRows = numDictionaryRows;
+    header.bitsPerIndex = bitsPerIndex;
+    header.indicesOffset = (uint32_t)(sizeof(CompressedLevelHeader) + dictionary.size());
+
+    const size_t size = header.indicesOffset + (size_t)getIndicesSize((uint64_t)world->numRows, bitsPerIndex);
+    uint8_t* data = (uint8_t*)calloc(size, 1);
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + sizeof(header), dictionary.data(), dictionary.size());
+
+    // Pack the indices, they never straddle more than one 8-byte word
+    uint8_t* packed = data + header.indicesOffset;
+    uint64_t bitOffset = 0;
+    for (int y = 0; y < world->numRows; y++) {
+        uint64_t bits = 0;
+        memcpy(&bits, packed + (bitOffset >> 3), sizeof(bits));
+        bits |= (uint64_t)indices[y] << (bitOffset & 7);
+        memcpy(packed + (bitOffset >> 3), &bits, sizeof(bits));
+        bitOffset += bitsPerIndex;
+    }
+
+    free(indices);
+    *outSize = size;
+    return data;
+}
+
+bool levelCompressWrite(const World* world, const char* path) {
+    size_t size = 0;
+    uint8_t* data = levelCompress(world, &size);
+    if (!data) return false;
+
+    char tempPath[1024];
+    FILE* file = NULL;
+    if (snprintf(tempPath, sizeof(tempPath), "%s.tmp", path) < (int)sizeof(tempPath)) file = fopen(tempPath, "wb");
+    if (!file) {
+        free(data);
+        return false;
+    }
+
+    bool isOk = fwrite(data, 1, size, file) == size;
+    isOk = fclose(file) == 0 && isOk;
+    free(data);
+    if (!isOk) {
+        remove(tempPath);
+        return false;
+    }
+
+#ifdef _WIN32
+    return MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(tempPath, path) == 0;
+#endif
+}
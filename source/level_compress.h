@@ -0,0 +1,60 @@
+// Compressed level files
+// ----------------------
+// Level files (`level_file.h`) spend a byte on every tile, so the game can use them in place.
+// That's wasteful for shipping and downloading big level packs, where most rows are walls and empty space.
+//
+// A compressed level stores every distinct row of tiles once (the dictionary, shared by all screens)
+// and every row of the level as an index into it, bit-packed into as few bits as the dictionary needs.
+// A 100k-screen level (1.2M rows) with a few thousand distinct rows takes 12 bits per row, about 2 MB.
+//
+// Decoding makes a regular level file image in memory. Every row is one unaligned load to get its index,
+// a 16-byte copy of the dictionary row and a copy of its precomputed collision mask row, so it runs at memory bandwidth.
+// `levelFileOpen` and `levelFileLoad` decode compressed files on their own, the rest of the game never sees them.
+//
+// File layout (little-endian):
+//  header:     `CompressedLevelHeader`
+//  dictionary: `numDictionaryRows` rows of TILEMAP_SIZE_X bytes (ASCII `Tile`s)
+//  indices:    one `bitsPerIndex`-bit index per row of the level (top row first), packed from the lowest bit of the first byte,
+//              followed by LEVEL_COMPRESS_PADDING zero bytes
+//
+// Use tools/level_pack.cpp with `--compress` to make compressed level files.
+#pragma once
+
+#include "sim.h"
+#include <stddef.h> // size_t
+
+#define LEVEL_COMPRESS_MAGIC "JPLZ"
+#define LEVEL_COMPRESS_VERSION 1u
+// Indices are read with 8-byte loads, this many bytes after the last one keep them inside of the file
+#define LEVEL_COMPRESS_PADDING 8
+// Up to 16M distinct rows, so an index plus its bit offset always fits into one 8-byte load
+#define LEVEL_COMPRESS_MAX_INDEX_BITS 24
+
+struct CompressedLevelHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numScreens;
+    // Tiles of a single screen, has to match TILEMAP_SIZE_X and TILEMAP_SIZE_Y
+    uint32_t screenSizeX;
+    uint32_t screenSizeY;
+    uint32_t numDictionaryRows;
+    uint32_t bitsPerIndex;
+    // Byte offset of the indices from the start of the file
+    uint32_t indicesOffset;
+};
+
+static_assert(sizeof(CompressedLevelHeader) == 32, "CompressedLevelHeader is stored in files as is");
+
+// Does the data start with a compressed level header?
+bool levelIsCompressed(const uint8_t* data, size_t size);
+
+// Size of the level file image `levelDecompress` makes, zero if the data isn't a valid compressed level.
+size_t levelGetDecompressedSize(const uint8_t* data, size_t size);
+// Decode a compressed level into a level file image (see `level_file.h`) of `levelGetDecompressedSize` bytes.
+// Returns false if the data is invalid (e.g. an index past the dictionary).
+bool levelDecompress(const uint8_t* data, size_t size, uint8_t* outImage, size_t outSize);
+
+// Encode the `world`. The returned buffer has to be freed with `free`.
+uint8_t* levelCompress(const World* world, size_t* outSize);
+// Write the `world` as a compressed level file, through a temporary file like `levelFileWrite`.
+bool levelCompressWrite(const World* world, const char* path);
@@ -0,0 +1,213 @@
+#include "level_file.h"
+#include "level_compress.h"
+#include <stdio.h>
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcmp, memcpy
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h> // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close
+#endif
+
+// Everything the header promises has to be inside of the file, so the world can't read past the mapping.
+static bool isHeaderValid(const LevelFileHeader* header, size_t fileSize) {
+    if (memcmp(header->magic, LEVEL_FILE_MAGIC, 4) != 0 || header->version != LEVEL_FILE_VERSION) return false;
+    if (header->screenSizeX != TILEMAP_SIZE_X || header->screenSizeY != TILEMAP_SIZE_Y) return false;
+    if (header->rowStride < TILEMAP_SIZE_X || header->numScreens == 0) return false;
+    if (header->maskOffset % sizeof(uint16_t) != 0) return false;
+
+    const uint64_t numRows = (uint64_t)header->numScreens * TILEMAP_SIZE_Y;
+    const uint64_t tilesEnd = header->tilesOffset + numRows * header->rowStride;
+    const uint64_t maskEnd = header->maskOffset + numRows * sizeof(uint16_t);
+    return header->tilesOffset >= sizeof(LevelFileHeader) && header->maskOffset >= sizeof(LevelFileHeader) &&
+        tilesEnd <= fileSize && maskEnd <= fileSize;
+}
+
+// Compressed levels are decoded into memory, the file itself isn't needed after that.
+static bool decompressLevel(LevelFile* file) {
+    const size_t size = levelGetDecompressedSize(file->data, file->size);
+    uint8_t* image = size > 0 ? (uint8_t*)malloc(size) : NULL;
+    const bool isOk = image && levelDecompress(file->data, file->size, image, size);
+    levelFileClose(file);
+    if (!isOk) {
+        free(image);
+        return false;
+    }
+
+    file->data = image;
+    file->size = size;
+    return true;
+}
+
+bool levelFileOpen(LevelFile* file, const char* path) {
+    *file = {};
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(LevelFileHeader)) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* data = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data) {
+        if (mappingHandle) CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    file->data = (const uint8_t*)data;
+    file->size = (size_t)fileSize.QuadPart;
+    file->isMapped = true;
+    file->fileHandle = fileHandle;
+    file->mappingHandle = mappingHandle;
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(LevelFileHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after closing the descriptor
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    file->data = (const uint8_t*)data;
+    file->size = (size_t)fileStat.st_size;
+    file->isMapped = true;
+#endif
+
+    if (levelIsCompressed(file->data, file->size) && !decompressLevel(file)) return false;
+
+    LevelFileHeader header = {};
+    memcpy(&header, file->data, sizeof(header));
+    if (!isHeaderValid(&header, file->size)) {
+        levelFileClose(file);
+        return false;
+    }
+
+    return true;
+}
+
+bool levelFileLoad(LevelFile* file, const char* path) {
+    *file = {};
+
+    FILE* handle = fopen(path, "rb");
+    if (!handle) return false;
+
+    fseek(handle, 0, SEEK_END);
+    const long fileSize = ftell(handle);
+    fseek(handle, 0, SEEK_SET);
+    if (fileSize < (long)sizeof(LevelFileHeader)) {
+        fclose(handle);
+        return false;
+    }
+
+    uint8_t* data = (uint8_t*)malloc(fileSize);
+    const size_t numRead = fread(data, 1, fileSize, handle);
+    fclose(handle);
+
+    file->data = data;
+    file->size = (size_t)fileSize;
+    if (numRead != (size_t)fileSize) {
+        levelFileClose(file);
+        return false;
+    }
+    if (levelIsCompressed(file->data, file->size) && !decompressLevel(file)) return false;
+
+    LevelFileHeader header = {};
+    memcpy(&header, file->data, sizeof(header));
+    if (!isHeaderValid(&header, file->size)) {
+        levelFileClose(file);
+        return false;
+    }
+
+    return true;
+}
+
+void levelFileClose(LevelFile* file) {
+    if (!file->data) return;
+
+    if (!file->isMapped) {
+        free((void*)file->data);
+        *file = {};
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+    CloseHandle((HANDLE)file->mappingHandle);
+    CloseHandle((HANDLE)file->fileHandle);
+#else
+    munmap((void*)file->data, file->size);
+#endif
+
+    *file = {};
+}
+
+void levelFileGetWorld(const LevelFile* file, World* world) {
+    LevelFileHeader header = {};
+    memcpy(&header, file->data, sizeof(header));
+
+    *world = {};
+    world->tiles = file->data + header.tilesOffset;
+    world->rowStride = (int)header.rowStride;
+    world->numScreens = (int)header.numScreens;
+    world->numRows = world->numScreens * TILEMAP_SIZE_Y;
+    world->topY = -(float)((world->numScreens - 1) * TILEMAP_SIZE_Y);
+    world->mask.rows = (const uint16_t*)(file->data + header.maskOffset);
+    world->mask.numRows = world->numRows;
+    world->mask.tiles = world->tiles;
+    world->mask.rowStride = world->rowStride;
+}
+
+bool levelFileWrite(const World* world, const char* path) {
+    char tempPath[1024];
+    if (snprintf(tempPath, sizeof(tempPath), "%s.tmp", path) >= (int)sizeof(tempPath)) return false;
+
+    FILE* file = fopen(tempPath, "wb");
+    if (!file) return false;
+
+    // Rows are stored without the string terminators of `Tilemap`
+    LevelFileHeader header = {};
+    memcpy(header.magic, LEVEL_FILE_MAGIC, 4);
+    header.version = LEVEL_FILE_VERSION;
+    header.numScreens = (uint32_t)world->numScreens;
+    header.screenSizeX = TILEMAP_SIZE_X;
+    header.screenSizeY = TILEMAP_SIZE_Y;
+    header.rowStride = TILEMAP_SIZE_X;
+    header.tilesOffset = sizeof(LevelFileHeader);
+    header.maskOffset = header.tilesOffset + (uint32_t)(world->numRows * TILEMAP_SIZE_X);
+
+    bool isOk = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int y = 0; y < world->numRows && isOk; y++) {
+        isOk = fwrite(&world->tiles[(size_t)y * world->rowStride], 1, TILEMAP_SIZE_X, file) == TILEMAP_SIZE_X;
+    }
+    isOk = isOk && fwrite(world->mask.rows, sizeof(uint16_t), world->numRows, file) == (size_t)world->numRows;
+
+    isOk = fclose(file) == 0 && isOk;
+    if (!isOk) {
+        remove(tempPath);
+        return false;
+    }
+
+#ifdef _WIN32
+    return MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(tempPath, path) == 0;
+#endif
+}
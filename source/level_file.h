@@ -0,0 +1,65 @@
+// Level files
+// -----------
+// Levels stored on disk, so they can be edited and shipped without rebuilding the game.
+// The file is memory-mapped and used in place: the tiles and the collision mask are stored exactly
+// the way `World` reads them, so opening a level is just a few header checks, no matter how big it is.
+//
+// File layout (little-endian):
+//  header: `LevelFileHeader`
+//  tiles:  `numScreens * screenSizeY` rows of `rowStride` bytes (ASCII `Tile`s), top row of the level first
+//  mask:   one u16 per row (bit X is set if tile X is full), see `CollisionMask`
+//
+// Use tools/level_pack.cpp to make level files. Big levels can be compressed for shipping, see `level_compress.h`.
+#pragma once
+
+#include "sim.h"
+#include <stddef.h> // size_t
+
+#define LEVEL_FILE_MAGIC "JPLV"
+// The mask is made with the tile materials of the version, files with older masks are rejected (repack them).
+// 2: wind tiles ('<', '>', '^') aren't solid anymore.
+#define LEVEL_FILE_VERSION 2u
+
+struct LevelFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t numScreens;
+    // Tiles of a single screen, has to match TILEMAP_SIZE_X and TILEMAP_SIZE_Y
+    uint32_t screenSizeX;
+    uint32_t screenSizeY;
+    // Bytes between two rows of tiles
+    uint32_t rowStride;
+    // Byte offsets of the sections from the start of the file
+    uint32_t tilesOffset;
+    uint32_t maskOffset;
+};
+
+static_assert(sizeof(LevelFileHeader) == 32, "LevelFileHeader is stored in files as is");
+
+// Read-only mapping (or copy) of a level file.
+struct LevelFile {
+    const uint8_t* data;
+    size_t size;
+    // False if the file was read into memory by `levelFileLoad` or decoded from a compressed level
+    bool isMapped;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+// Map the file and check it's a valid level. The file stays mapped until `levelFileClose`.
+// Compressed levels (`level_compress.h`) are decoded into memory instead.
+bool levelFileOpen(LevelFile* file, const char* path);
+// Read the whole file into memory instead, so the file on disk can be replaced while it's in use
+// (Windows doesn't allow that for mapped files). Used when hot reloading levels.
+bool levelFileLoad(LevelFile* file, const char* path);
+void levelFileClose(LevelFile* file);
+
+// Make a world which uses the tiles and the collision mask of the mapped file in place.
+// The world doesn't own anything, `worldFree` on it is fine but the file has to outlive it.
+void levelFileGetWorld(const LevelFile* file, World* world);
+
+// Write the `world` as a level file.
+// It's written to a temporary file first and then renamed, so nobody ever sees a half-written level.
+bool levelFileWrite(const World* world, const char* path);
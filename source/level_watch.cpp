@@ -0,0 +1,129 @@
+#include "level_watch.h"
+#include <string.h> // strcmp
+#include <sys/stat.h> // stat
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h> // read, close
+#endif
+
+struct LevelWatch {
+    std::string path;
+    std::thread thread;
+    std::atomic<bool> isStopping;
+
+    // Latest loaded version, waiting for the game to take it
+    std::mutex mutex;
+    LevelFile pending;
+    bool hasPending;
+};
+
+// Load the file and hand it over to the game, replacing an older version it didn't take yet.
+static void loadUpdate(LevelWatch* watch) {
+    LevelFile file = {};
+    // Might be half-written (or gone for a moment), the next change event tries again
+    if (!levelFileLoad(&file, watch->path.c_str())) return;
+
+    std::lock_guard<std::mutex> lock(watch->mutex);
+    if (watch->hasPending) levelFileClose(&watch->pending);
+    watch->pending = file;
+    watch->hasPending = true;
+}
+
+// Fallback: check the modification time every LEVEL_WATCH_POLL_MS.
+// Note: the time often only has a resolution of seconds, so the size is compared as well.
+static void pollFile(LevelWatch* watch) {
+    struct stat lastStat = {};
+    stat(watch->path.c_str(), &lastStat);
+
+    while (!watch->isStopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(LEVEL_WATCH_POLL_MS));
+
+        struct stat fileStat = {};
+        if (stat(watch->path.c_str(), &fileStat) != 0) continue;
+        if (fileStat.st_mtime == lastStat.st_mtime && fileStat.st_size == lastStat.st_size) continue;
+
+        lastStat = fileStat;
+        loadUpdate(watch);
+    }
+}
+
+#ifdef __linux__
+// Watch the directory rather than the file: editors and `levelFileWrite` replace the file with a new one,
+// which would end a watch on the file itself.
+static void watchFile(LevelWatch* watch) {
+    const std::string& path = watch->path;
+    const size_t slash = path.find_last_of('/');
+    const std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    const std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        if (fd >= 0) close(fd);
+        pollFile(watch);
+        return;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    while (!watch->isStopping) {
+        // Wake up now and then to check if we should stop
+        pollfd pollFd = { fd, POLLIN, 0 };
+        if (poll(&pollFd, 1, LEVEL_WATCH_POLL_MS) <= 0) continue;
+
+        bool isChanged = false;
+        for (;;) {
+            const ssize_t numRead = read(fd, buffer, sizeof(buffer));
+            if (numRead <= 0) break;
+
+            for (ssize_t offset = 0; offset < numRead;) {
+                const inotify_event* event = (const inotify_event*)&buffer[offset];
+                if (event->len > 0 && strcmp(event->name, name.c_str()) == 0) isChanged = true;
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if (isChanged) loadUpdate(watch);
+    }
+
+    close(fd);
+}
+#else
+static void watchFile(LevelWatch* watch) {
+    pollFile(watch);
+}
+#endif
+
+LevelWatch* levelWatchStart(const char* path) {
+    LevelWatch* watch = new LevelWatch();
+    watch->path = path;
+    watch->isStopping = false;
+    watch->hasPending = false;
+    watch->pending = {};
+    watch->thread = std::thread(watchFile, watch);
+    return watch;
+}
+
+void levelWatchStop(LevelWatch* watch) {
+    if (!watch) return;
+
+    watch->isStopping = true;
+    watch->thread.join();
+    if (watch->hasPending) levelFileClose(&watch->pending);
+    delete watch;
+}
+
+bool levelWatchTakeUpdate(LevelWatch* watch, LevelFile* outFile) {
+    std::lock_guard<std::mutex> lock(watch->mutex);
+    if (!watch->hasPending) return false;
+
+    *outFile = watch->pending;
+    watch->pending = {};
+    watch->hasPending = false;
+    return true;
+}
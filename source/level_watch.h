@@ -0,0 +1,24 @@
+// Level hot reload
+// ----------------
+// Watches a level file on a background thread and loads it again whenever it changes on disk,
+// so edits show up in the running game within a frame.
+// On Linux the thread sleeps on inotify, elsewhere it polls the modification time.
+//
+// The watcher only loads and validates the file, the game picks the new version up at a frame boundary
+// with `levelWatchTakeUpdate` and swaps it in itself (see `swapLevel` in main.cpp).
+#pragma once
+
+#include "level_file.h"
+
+// How often the file is checked when there's no inotify
+#define LEVEL_WATCH_POLL_MS 100
+
+struct LevelWatch;
+
+// Start watching the file at `path` (it doesn't have to exist yet).
+LevelWatch* levelWatchStart(const char* path);
+void levelWatchStop(LevelWatch* watch);
+
+// Take the newest version of the level, if it changed since the last call.
+// The caller owns `outFile` and has to close it. Doesn't block.
+bool levelWatchTakeUpdate(LevelWatch* watch, LevelFile* outFile);
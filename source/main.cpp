@@ -1,64 +1,44 @@
 #include "raylib.h" // Base Raylib header
 #include "raymath.h" // Vector math
+#include "sim.h" // Simulation core: tilemaps, collision, player movement
+#include "replay.h" // Input recording and playback
+#include "level_file.h" // Memory-mapped level files
+#include "level_watch.h" // Level hot reload
+#include "autotile.h" // Tileset sprite selection
+#include "screen_cache.h" // Streaming of per-screen data
+#include "sprite_batch.h" // Batched sprite drawing with rlgl
+#include "ghosts.h" // Recorded runs to race against
+#include "profiler.h" // Frame phase timers for the debug overlay
+#include "trace.h" // Chrome trace export
 #include <stdint.h>
 #include <stdio.h> // printf
+#include <stdlib.h> // malloc, free
+#include <string.h> // strcmp
+#include <time.h> // clock
 #include <assert.h> // assert
 
-#define TILEMAP_SIZE_X 16
-#define TILEMAP_SIZE_Y 12
 // How wide and tall is each tile in pixels
 #define TILE_PIXELS 16
-// What happens when we get out of grid horizontally
-#define OUTSIDE_TILE_HORIZONTAL TILE_FULL
-// What happens when we get out of grid vertically
-#define OUTSIDE_TILE_VERTICAL TILE_EMPTY
-// How much should the box in `resolveBoxCollisionWithTilemap` bounce of off walls.
-// Mainly player uses this to bounce.
-#define BOUNCE_FACTOR_X 0.45f
 
 #define VIEW_PIXELS_X (TILEMAP_SIZE_X * TILE_PIXELS)
 #define VIEW_PIXELS_Y (TILEMAP_SIZE_Y * TILE_PIXELS)
 #define BACKGROUND_COLOR Color{ 15, 5, 45, 255 }
 
-// Number of items in a static (fixed-size) array
-#define arrayNumItems(arr) (sizeof(arr) / sizeof((arr)[0]))
-
-// Half-size of the player's box collider.
-#define PLAYER_SIZE Vector2{0.3f, 0.4f}
-// Gravity in units (tiles) per second
-#define PLAYER_GRAVITY 30.0f
-// How fast player accelerates.
-#define PLAYER_SPEED 200.0f
-#define PLAYER_GROUND_FRICTION_X 70.0f
-#define PLAYER_JUMP_STRENGTH 15.0f
-
-struct Player {
-    Vector2 position;
-    Vector2 velocity;
-    float jumpHoldTime;
-    float animTime;
-    bool isOnGround;
-    bool isFacingRight;
-};
-
-enum Tile { TILE_EMPTY = ' ', TILE_ZERO = '\0', TILE_FULL = '#' };
+// Default limit of simulation ticks per rendered frame. When a frame takes too long,
+// the remaining time is dropped (the game slows down) instead of the simulation cost
+// growing without bounds. Can be changed with `--max-substeps <n>`.
+#define DEFAULT_MAX_SUBSTEPS 8
 
-// Tilemap is a grid of tiles (`Tile` enums, stored as unsigned bytes).
-// The '+ 1' is there for string null-termination, because
-// we're defining the tilemaps with strings.
-typedef uint8_t Tilemap[TILEMAP_SIZE_Y][TILEMAP_SIZE_X + 1];
+// Ghosts on the visible screen go into one batch of this many quads (one draw unless there are more)
+#define GHOST_BATCH_CAPACITY 8192
+#define GHOST_TINT Color{ 255, 255, 255, 96 }
 
-Tile tilemapGetTile(const Tilemap* tilemap, int x, int y) {
-    if (x < 0 || x >= TILEMAP_SIZE_X) return OUTSIDE_TILE_HORIZONTAL;
-    if (y < 0 || y >= TILEMAP_SIZE_Y) return OUTSIDE_TILE_VERTICAL;
-    return (Tile)(*tilemap)[y][x];
-}
-
-Tile tilemapGetTileFullOutside(const Tilemap* tilemap, int x, int y) {
-    if (x < 0 || x >= TILEMAP_SIZE_X) return TILE_FULL;
-    if (y < 0 || y >= TILEMAP_SIZE_Y) return TILE_FULL;
-    return (Tile)(*tilemap)[y][x];
-}
+// Frame time graph of the debug overlay: pixels per frame, height, and the time at the top of it
+#define PROFILER_GRAPH_BAR_WIDTH 2
+#define PROFILER_GRAPH_HEIGHT 80
+#define PROFILER_GRAPH_MAX_US 33333.0f
+// Frames slower than this (60 FPS) are drawn red
+#define PROFILER_FRAME_BUDGET_US 16667.0f
 
 // Converts a center (vector) from world-space to screen-space.
 // In world-space one unit is one tile in size, so coordinate [1, 1] means tile at this coordinate.
@@ -68,318 +48,300 @@ Vector2 worldToScreen(const Vector2 worldSpacePos) {
     return Vector2Scale(worldSpacePos, TILE_PIXELS);
 }
 
-bool tilemapIsTileFull(const Tilemap* tilemap, int x, int y) {
-    const Tile tile = tilemapGetTile(tilemap, x, y);
-    if (tile == TILE_EMPTY || tile == TILE_ZERO) return false;
-    return true;
+// Sample the keyboard into simulation input bits.
+Input readInput() {
+    PROFILE_SCOPE(PROFILE_INPUT);
+    Input input = 0;
+    if (IsKeyDown(KEY_SPACE)) input |= INPUT_JUMP;
+    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) input |= INPUT_LEFT;
+    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) input |= INPUT_RIGHT;
+    return input;
 }
 
+void drawSpriteSheetTile(const Texture texture, const int spriteX, const int spriteY, const int spriteSize,
+    const Vector2 position, const Vector2 scale = { 1, 1 }) {
+    DrawTextureRec(
+        texture,
+        { (float)(spriteX * spriteSize), (float)(spriteY * spriteSize), (float)spriteSize * scale.x, (float)spriteSize * scale.y},
+        position, WHITE);
+}
 
-// List of tilemaps for each screen in the level.
-// Note: starts at the bottom, so it looks continuous
-const Tilemap screenTilemaps[] = {
-    {
-        // Index zero is empty
-        // This index is reserved for 'invalid tilemap'
-    },
-     {
-        "################",
-        "#              #",
-        "# #### #### #  #",
-        "# #    #    #  #",
-        "# # ## # ## #  #",
-        "# #  # #  #    #",
-        "# #### #### #  #",
-        "#              #",
-        "#              #",
-        "#              #",
-        "#              #",
-        "#########      #",
-    },
-    {
-        "#########      #",
-        "#########    ###",
-        "########      ##",
-        "########      ##",
-        "##########     #",
-        "##########     #",
-        "########      ##",
-        "########      ##",
-        "##########    ##",
-        "######        ##",
-        "###           ##",
-        "###         ####",
-    },
-    {
-        "###         ####",
-        "###    ##   ####",
-        "###         ####",
-        "###          ###",
-        "#####        ###",
-        "###          ###",
-        "#            ###",
-        "##        ######",
-        "##         #####",
-        "##         #####",
-        "######     #####",
-        "#####      #####",
-    },
-    {
-        "#####      #####",
-        "###      #######",
-        "##        ######",
-        "##          ####",
-        "######      ####",
-        "######       ###",
-        "######   #   ###",
-        "#####    ##  ###",
-        "#####        ###",
-        "##           ###",
-        "##        ######",
-        "##    ##########",
-    },
-    // Starting screen:
-    {
-        "##    ##########",
-        "##            ##",
-        "####          ##",
-        "########       #",
-        "#####          #",
-        "##             #",
-        "##       #######",
-        "#        #######",
-        "#         ######",
-        "#####     ######",
-        "#####     ######",
-        "################",
-    },
-};
+// Rolling min/avg/p99 of every frame phase, and a graph of the last frame times.
+// Times are what the CPU spends, GPU work mostly shows up in "present" (it waits for the GPU and vsync).
+void drawProfilerOverlay(int posX, int posY) {
+    const int columnX[] = { posX, posX + 150, posX + 240, posX + 330 };
+    DrawText("phase (us)", columnX[0], posY, 20, YELLOW);
+    DrawText("min", columnX[1], posY, 20, YELLOW);
+    DrawText("avg", columnX[2], posY, 20, YELLOW);
+    DrawText("p99", columnX[3], posY, 20, YELLOW);
+    for (int i = 0; i < PROFILE_PHASE_COUNT; i++) {
+        const ProfileStats stats = profilerGetStats((ProfilePhase)i);
+        const int y = posY + 22 * (i + 1);
+        DrawText(profilerGetPhaseName((ProfilePhase)i), columnX[0], y, 20, WHITE);
+        DrawText(TextFormat("%.1f", stats.min), columnX[1], y, 20, WHITE);
+        DrawText(TextFormat("%.1f", stats.avg), columnX[2], y, 20, WHITE);
+        DrawText(TextFormat("%.1f", stats.p99), columnX[3], y, 20, WHITE);
+    }
 
-// Get the screen index, where start = 0 and increases when you move up (-Y)
-int getScreenHeightIndex(float height) {
-    return floorf(-height / TILEMAP_SIZE_Y);
+    float times[PROFILER_HISTORY_FRAMES];
+    const int numFrames = profilerGetHistory(PROFILE_FRAME, times);
+    const int graphY = posY + 22 * (PROFILE_PHASE_COUNT + 1) + 4;
+    DrawRectangle(posX, graphY, PROFILER_HISTORY_FRAMES * PROFILER_GRAPH_BAR_WIDTH, PROFILER_GRAPH_HEIGHT, Fade(BLACK, 0.6f));
+    for (int i = 0; i < numFrames; i++) {
+        const int height = (int)(fminf(times[i] / PROFILER_GRAPH_MAX_US, 1.0f) * PROFILER_GRAPH_HEIGHT);
+        DrawRectangle(posX + i * PROFILER_GRAPH_BAR_WIDTH, graphY + PROFILER_GRAPH_HEIGHT - height, PROFILER_GRAPH_BAR_WIDTH, height,
+            times[i] > PROFILER_FRAME_BUDGET_US ? RED : GREEN);
+    }
+    // Line at the frame budget
+    const int budgetY = graphY + PROFILER_GRAPH_HEIGHT - (int)(PROFILER_FRAME_BUDGET_US / PROFILER_GRAPH_MAX_US * PROFILER_GRAPH_HEIGHT);
+    DrawRectangle(posX, budgetY, PROFILER_HISTORY_FRAMES * PROFILER_GRAPH_BAR_WIDTH, 1, YELLOW);
 }
 
-// Get start and end coordinates of the boxes a bounding box on the tilemap grid
-void getTilesOverlappedByBox(int* outStartX, int* outStartY, int* outEndX, int* outEndY, Vector2 center, const Vector2 size) {
-    *outStartX = int(floorf(center.x - size.x));
-    *outStartY = int(floorf(center.y - size.y));
-    *outEndX = int(floorf(center.x + size.x));
-    *outEndY = int(floorf(center.y + size.y));
+// The tiles don't move, so instead of drawing every tile each frame,
+// the visible screen is drawn into a texture once and re-used until the screen changes.
+// A few screens are kept baked: the visible one and the ones above and below it (baked ahead of time),
+// so crossing into them doesn't have to draw anything.
+#define STATIC_LAYER_COUNT 3
+
+struct StaticLayerCache {
+    RenderTexture texture;
+    // Screen which is currently in the texture
+    int screenIndex;
+    // Set to false to force a rebuild (e.g. after the level was edited)
+    bool isValid;
+    // Frame when it was last shown, the least recently shown layer gets re-used
+    uint64_t lastUsedFrame;
+};
+
+// Color the tile is drawn with, from its material
+Color getTileTint(const World* world, int x, int y) {
+    const TileMaterial* material = getTileMaterial((uint8_t)worldGetTile(world, x, y));
+    return { material->tint[0], material->tint[1], material->tint[2], material->tint[3] };
 }
 
-// This function takes a box and a tilemap, and tries to make sure the box
-// doesn't intersect with the tilemap.
-// 
-// The method:
-// First, we iterate all of the tiles that *could* be colliding with the box (based on the bounding volume).
-// Next, we calculate the distance between near surfaces on each axis.
-// Then we find an axis to 'clip' the position and velocity against.
-// 
-// Note: the `size` is half-extent: it's the vector from the center of the box to it's corner.
-//  It's half the actual width and height of the box.
-void resolveBoxCollisionWithTilemap(const Tilemap* tilemap, float tilemapHeight, Vector2* center, Vector2* velocity, const Vector2 size) {
-    // Add the offset to center (simply transform into tilemap local-space)
-    center->y -= tilemapHeight;
-
-    int startX = 0;
-    int startY = 0;
-    int endX = 0;
-    int endY = 0;
-    // Get neighbor tile ranges
-    getTilesOverlappedByBox(&startX, &startY, &endX, &endY, *center, size);
-
-    // Iterate over close tiles
-    for (int x = startX; x <= endX; x++) {
-        for (int y = startY; y <= endY; y++) {
-            // Skip if non-empty
-            if (!tilemapIsTileFull(tilemap, x, y)) continue;
-
-            // Center of the tile box
-            const Vector2 boxPos = { 0.5f + (float)x, 0.5f + (float)y };
-            const Vector2 sizeSum = { size.x + 0.5f, size.y + 0.5 };
-            const Vector2 surfDist = {
-                fabsf(center->x - boxPos.x) - sizeSum.x,
-                fabsf(center->y - boxPos.y) - sizeSum.y,
-            };
-
-            // The two boxes aren't colliding, because
-            // the distance between the surfaces is larger than
-            // zero on one of the axes.
-            if (surfDist.x > 0 || surfDist.y > 0) continue;
-
-            // Now check the closer neighboring tiles on each axis.
-            // If the tile is empty (and current tile is full), that means
-            // there exists an edge between the two tiles.
-            // Our box should collide against such an edge.
-            // On the other hand, if there is no edge, the box is inside the tiles
-            // and collision cannot be resolved.
-            const bool isXEmpty = !tilemapIsTileFull(tilemap, x + (center->x > boxPos.x ? 1 : -1), y);
-            // Warning: positive Y is down in this setup!
-            const bool isYEmpty = !tilemapIsTileFull(tilemap, x, y + (center->y > boxPos.y ? 1 : -1));
-
-            // If both neighbors are empty, there aren't any edges to collide against.
-            if (!isXEmpty && !isYEmpty) continue;
-
-            // Clip axis is the axis of an edge which we don't want our box to intersect.
-            bool isClipAxisX = isXEmpty;
-            // In case there are two edges, just get the axis which has the least amount of penetration.
-            if (isXEmpty && isYEmpty) {
-                isClipAxisX = surfDist.x > surfDist.y;
-            }
+// Draw the `sprites` of a screen (see `screenCacheGetSprites`) into the layer, NULL leaves it empty.
+void bakeStaticLayer(StaticLayerCache* layer, SpriteBatch* tileBatch, const World* world, const AutotileSprite* sprites, const Texture tilemapTexture, int screenIndex) {
+    TRACE_SCOPE("bakeStaticLayer");
+    BeginTextureMode(layer->texture);
+    ClearBackground(BACKGROUND_COLOR);
+
+    if (sprites) {
+        const int screenRow = screenIndex * TILEMAP_SIZE_Y;
+
+        // Tiles you can pass through don't have sprites, the ones with a visible tint (wind zones) get shaded
+        for (int i = 0; i < TILEMAP_SIZE_X * TILEMAP_SIZE_Y; i++) {
+            const int x = i % TILEMAP_SIZE_X;
+            const int y = i / TILEMAP_SIZE_X;
+            const Color tint = getTileTint(world, x, screenRow + y);
+            if (sprites[i] != AUTOTILE_NONE || tint.a == 0) continue;
+            DrawRectangle(x * TILE_PIXELS, y * TILE_PIXELS, TILE_PIXELS, TILE_PIXELS, tint);
+        }
 
-            // Clip the velocity (or bounce) based on the axis
-            if (isClipAxisX) {
-                if (center->x > boxPos.x) {
-                    // Clamp the position exactly to the surface
-                    center->x = boxPos.x + sizeSum.x;
-                    if (velocity->x < 0.0) {
-                        velocity->x = -velocity->x * BOUNCE_FACTOR_X;
-                    }
-                }
-                else {
-                    center->x = boxPos.x - sizeSum.x;
-                    if (velocity->x > 0.0) {
-                        velocity->x = -velocity->x * BOUNCE_FACTOR_X;
-                    }
-                }
-            }
-            else {
-                if (center->y > boxPos.y) {
-                    center->y = boxPos.y + sizeSum.y;
-                    velocity->y = fmaxf(velocity->y, 0.0f);
-                }
-                else {
-                    center->y = boxPos.y - sizeSum.y;
-                    velocity->y = fminf(velocity->y, 0.0f);
-                }
-            }
-        } // y
-    } // x
+        // Draw tilemap, using the sprites which were picked when the screen was loaded.
+        // All tiles of the screen go into one vertex buffer and one draw call.
+        spriteBatchBegin(tileBatch, tilemapTexture);
+        for (int i = 0; i < TILEMAP_SIZE_X * TILEMAP_SIZE_Y; i++) {
+            const AutotileSprite sprite = sprites[i];
+            if (sprite == AUTOTILE_NONE) continue;
+
+            const int x = i % TILEMAP_SIZE_X;
+            const int y = i / TILEMAP_SIZE_X;
+            spriteBatchAdd(
+                tileBatch,
+                { (float)(autotileSpriteX(sprite) * TILE_PIXELS), (float)(autotileSpriteY(sprite) * TILE_PIXELS), TILE_PIXELS, TILE_PIXELS },
+                { (float)x * TILE_PIXELS, (float)y * TILE_PIXELS },
+                false, getTileTint(world, x, screenRow + y));
+        }
+        spriteBatchEnd(tileBatch);
+    }
 
-    // Remove the local-space offset
-    center->y += tilemapHeight;
-}
+    EndTextureMode();
 
-// Checks whether the box is intersecting any tile in the tilemap.
-// param `tilemap`: tilemap to check
-// param `tilemapHeight`: offset of the tilemap along the Y axis
-// param `center`: coordinate of the center of the box
-// param `size`: half-extent of the box - half the box sides
-bool isBoxCollidingWithTilemap(const Tilemap* tilemap, float tilemapHeight, Vector2 center, const Vector2 size) {
-    center.y -= tilemapHeight;
-
-    int startX = 0;
-    int startY = 0;
-    int endX = 0;
-    int endY = 0;
-    // Get neighbor tile ranges
-    getTilesOverlappedByBox(&startX, &startY, &endX, &endY, center, size);
-
-    // Iterate over close tiles
-    for (int x = startX; x <= endX; x++) {
-        for (int y = startY; y <= endY; y++) {
-            // Skip if non-empty
-            if (!tilemapIsTileFull(tilemap, x, y)) continue;
-
-            // Center of the tile box
-            const Vector2 boxPos = { 0.5f + (float)x, 0.5f + (float)y };
-            const Vector2 sizeSum = { size.x + 0.5f, size.y + 0.5 };
-            const Vector2 surfDist = {
-                fabsf(center.x - boxPos.x) - sizeSum.x,
-                fabsf(center.y - boxPos.y) - sizeSum.y,
-            };
-
-            // The two boxes aren't colliding, because
-            // the distance between the surfaces is larger than
-            // zero on one of the axes.
-            if (surfDist.x > 0 || surfDist.y > 0) continue;
-            return true;
-        } // y
-    } // x
-
-    return false;
+    layer->screenIndex = screenIndex;
+    layer->isValid = true;
 }
 
-// Read inputs and update player movement
-void updatePlayer(Player* player, const Tilemap* tilemap, float tilemapHeight, float delta) {
-    player->velocity.y += PLAYER_GRAVITY * delta;
-    const bool isOnGround = isBoxCollidingWithTilemap(
-        tilemap,
-        tilemapHeight,
-        { player->position.x, player->position.y + PLAYER_SIZE.y },
-        { 0.1, 0.05 });
-
-    player->isOnGround = isOnGround;
-
-    if (isOnGround) {
-        player->velocity.x = 0;
-
-        if (IsKeyReleased(KEY_SPACE)) {
-            // Calculate strength based on how long the user held down the jump key.
-            // The numbers are kind of random, you play with it yourself.
-            const float jumpStrength = Clamp(player->jumpHoldTime * 2.6f, 1.1f, 2.0f) / 2.0f;
-
-            // If the player doesn't press anything, the direction is up.
-            Vector2 dir = { 0.0f, -1.0f };
-            const float xMoveStrength = 0.75f - (jumpStrength * 0.5f);
-            if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) dir.x += xMoveStrength;
-            if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) dir.x -= xMoveStrength;
-            // Make sure the vector is unit vector (length = 1.0).
-            dir = Vector2Normalize(dir);
-
-            // Multiply the vector length by the strength factor.
-            dir = Vector2Scale(dir, jumpStrength * PLAYER_JUMP_STRENGTH);
-            // Now apply the jump vector to the actual velocity
-            player->velocity = dir;
-        }
+// Layer with the screen baked in, or NULL if there isn't any.
+StaticLayerCache* findStaticLayer(StaticLayerCache* layers, int screenIndex) {
+    for (int i = 0; i < STATIC_LAYER_COUNT; i++) {
+        if (layers[i].isValid && layers[i].screenIndex == screenIndex) return &layers[i];
+    }
+    return NULL;
+}
 
-        if (IsKeyDown(KEY_SPACE)) {
-            player->jumpHoldTime += delta;
-        }
-        else {
-            player->jumpHoldTime = 0.0f;
-            if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) {
-                player->velocity.x += PLAYER_SPEED * delta;
-                player->isFacingRight = true;
-            }
-            if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) {
-                player->velocity.x -= PLAYER_SPEED * delta;
-                player->isFacingRight = false;
-            }
+// Layer to bake another screen into: an invalid one, or the least recently shown one other than `keepScreenIndex`.
+StaticLayerCache* getFreeStaticLayer(StaticLayerCache* layers, int keepScreenIndex) {
+    StaticLayerCache* result = NULL;
+    for (int i = 0; i < STATIC_LAYER_COUNT; i++) {
+        StaticLayerCache* layer = &layers[i];
+        if (!layer->isValid) return layer;
+        if (layer->screenIndex == keepScreenIndex) continue;
+        if (!result || layer->lastUsedFrame < result->lastUsedFrame) result = layer;
+    }
+    return result;
+}
 
-            if (IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_LEFT) || IsKeyPressed(KEY_D) || IsKeyPressed(KEY_A)) {
-                player->animTime = 0;
-            }
-        }
+// Swap in a new version of the level (from `levelWatchTakeUpdate`), at a frame boundary.
+// Only the derived data of the screens which changed is thrown away, the player stays where they are.
+// Ghost tracks were simulated in the old level, they are baked again.
+// Takes over `newFile`, the old one is closed.
+void swapLevel(World* world, LevelFile* levelFile, LevelFile* newFile, ScreenCache* screenCache, StaticLayerCache* staticLayers, Ghosts* ghosts) {
+    World newWorld = {};
+    levelFileGetWorld(newFile, &newWorld);
+
+    // The streaming worker reads the world
+    screenCachePause(screenCache);
+
+    // Screens are stacked from the starting screen up, so world positions stay on the same screen
+    // even if screens were added or removed at the top.
+    if (newWorld.numScreens != world->numScreens) {
+        *world = newWorld;
+        screenCacheInvalidateAll(screenCache);
+        for (int i = 0; i < STATIC_LAYER_COUNT; i++) staticLayers[i].isValid = false;
     }
     else {
-        player->jumpHoldTime = 0.0f;
+        const World oldWorld = *world;
+        *world = newWorld;
+        for (int i = 0; i < world->numScreens; i++) {
+            if (worldIsScreenEqual(&oldWorld, world, i)) continue;
+
+            // The edge rows of the neighbors are autotiled against this screen as well
+            for (int screen = i - 1; screen <= i + 1; screen++) {
+                screenCacheInvalidate(screenCache, screen);
+                StaticLayerCache* layer = findStaticLayer(staticLayers, screen);
+                if (layer) layer->isValid = false;
+            }
+        }
     }
 
-    // Clamp velocity
-    float vel = Vector2Length(player->velocity);
-    if (vel > 25.0) vel = 25.0;
-    player->velocity = Vector2Scale(Vector2Normalize(player->velocity), vel);
+    // The collision mask comes with the file, the old world's data is in the old file
+    levelFileClose(levelFile);
+    *levelFile = *newFile;
+    *newFile = {};
 
-    player->position = Vector2Add(player->position, Vector2Scale(player->velocity, delta));
-}
+    screenCacheResume(screenCache);
 
-void drawSpriteSheetTile(const Texture texture, const int spriteX, const int spriteY, const int spriteSize,
-    const Vector2 position, const Vector2 scale = { 1, 1 }) {
-    DrawTextureRec(
-        texture,
-        { (float)(spriteX * spriteSize), (float)(spriteY * spriteSize), (float)spriteSize * scale.x, (float)spriteSize * scale.y},
-        position, WHITE);
+    ghostsRebake(ghosts, world);
 }
 
-
 // Entry point of the program
 // --------------------------
 int main(int argc, const char** argv) {
+    // Command line
+    // ------------
+    // --record <file>    record inputs of this session into a replay file
+    // --playback <file>  re-simulate a replay without a window, as fast as possible, and exit
+    // --max-substeps <n> limit of simulation ticks per rendered frame
+    // --level <file>     play a level file (see level_file.h) instead of the built-in level
+    // --watch            reload the level file whenever it changes on disk
+    // --ghost <file>     race against a recorded replay (can be repeated)
+    // --ghosts <dir>     race against every replay in the directory
+    // --trace <file>     write a Chrome trace (JSON) of every frame, see trace.h
+
+    const char* recordPath = NULL;
+    const char* playbackPath = NULL;
+    const char* levelPath = NULL;
+    int maxSubsteps = DEFAULT_MAX_SUBSTEPS;
+    bool isWatchingLevel = false;
+    const char* ghostDirectory = NULL;
+    const char* tracePath = NULL;
+    // There can't be more ghost paths than arguments
+    const char** ghostPaths = (const char**)malloc(sizeof(const char*) * argc);
+    int numGhostPaths = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--watch") == 0) isWatchingLevel = true;
+    }
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--playback") == 0) playbackPath = argv[++i];
+        else if (strcmp(argv[i], "--max-substeps") == 0) maxSubsteps = TextToInteger(argv[++i]);
+        else if (strcmp(argv[i], "--level") == 0) levelPath = argv[++i];
+        else if (strcmp(argv[i], "--ghost") == 0) ghostPaths[numGhostPaths++] = argv[++i];
+        else if (strcmp(argv[i], "--ghosts") == 0) ghostDirectory = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0) tracePath = argv[++i];
+    }
+    if (maxSubsteps < 1) maxSubsteps = 1;
+
+    // The level, as one tall grid of tiles.
+    // Level files are used in place, they stay mapped until the game exits.
+    // When watching, they are read into memory instead, so the file can be replaced while the game runs.
+    World world = {};
+    LevelFile levelFile = {};
+    if (levelPath) {
+        const bool isOpened = isWatchingLevel ? levelFileLoad(&levelFile, levelPath) : levelFileOpen(&levelFile, levelPath);
+        if (!isOpened) {
+            printf("failed to open level '%s'\n", levelPath);
+            free(ghostPaths);
+            return 1;
+        }
+        levelFileGetWorld(&levelFile, &world);
+    }
+    else {
+        worldInitBuiltin(&world);
+    }
+
+    if (playbackPath) {
+        Replay replay = {};
+        if (!replayLoad(&replay, playbackPath)) {
+            printf("failed to load replay '%s'\n", playbackPath);
+            worldFree(&world);
+            levelFileClose(&levelFile);
+            free(ghostPaths);
+            return 1;
+        }
+
+        SimState sim = {};
+        const clock_t start = clock();
+        const uint64_t numTicks = replayPlayback(&replay, &world, &sim);
+        const double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        printf("replay '%s': %llu ticks (%d runs) in %.3f s, %.0f ticks/s\n",
+            playbackPath, (unsigned long long)numTicks, replay.numRuns, seconds, seconds > 0.0 ? numTicks / seconds : 0.0);
+        printf("final player.position = [%f, %f], player.velocity = [%f, %f], isOnGround = %i\n",
+            sim.player.position.x, sim.player.position.y, sim.player.velocity.x, sim.player.velocity.y, sim.player.isOnGround);
+
+        replayFree(&replay);
+        worldFree(&world);
+        levelFileClose(&levelFile);
+        free(ghostPaths);
+        return 0;
+    }
+
     // Initialization
     // --------------
 
+    ReplayRecorder recorder = {};
+    if (recordPath && !replayRecorderOpen(&recorder, recordPath)) {
+        printf("failed to open replay '%s' for recording\n", recordPath);
+        worldFree(&world);
+        levelFileClose(&levelFile);
+        free(ghostPaths);
+        return 1;
+    }
+
+    // Ghosts are simulated once here (and again if the level is reloaded), and only looked up while racing.
+    // Loaded before the working directory changes, so relative paths work
+    Ghosts ghosts = {};
+    {
+        FilePathList directoryFiles = {};
+        if (ghostDirectory) directoryFiles = LoadDirectoryFiles(ghostDirectory);
+        ghostPaths = (const char**)realloc(ghostPaths, sizeof(const char*) * (numGhostPaths + directoryFiles.count + 1));
+        for (unsigned int i = 0; i < directoryFiles.count; i++) ghostPaths[numGhostPaths++] = directoryFiles.paths[i];
+
+        const int numLoaded = ghostsLoad(&ghosts, ghostPaths, numGhostPaths, &world);
+        if (numGhostPaths > 0) {
+            printf("ghosts: %d of %d replays loaded, %.1f MB of tracks\n", numLoaded, numGhostPaths, ghostsGetMemorySize(&ghosts) / 1e6);
+        }
+        if (ghostDirectory) UnloadDirectoryFiles(directoryFiles);
+        free(ghostPaths);
+    }
+
+    // Started after loading, so the ticks simulated for ghosts don't flood it
+    if (tracePath) {
+        if (traceStart(tracePath)) printf("tracing to '%s'\n", tracePath);
+        else printf("failed to start the trace '%s' (is JUMP_PRINCE_TRACE defined?)\n", tracePath);
+    }
+
     const int initialScreenWidth = TILEMAP_SIZE_X * TILE_PIXELS;
     const int initialScreenHeight = TILEMAP_SIZE_Y * TILE_PIXELS;
 
@@ -400,35 +362,72 @@ int main(int argc, const char** argv) {
 
     bool isDebugEnabled = false;
 
-    Player player = {};
-    player.position = {
-        (float)initialScreenWidth / (2 * TILE_PIXELS),
-        (float)initialScreenHeight / (2 * TILE_PIXELS) };
+    SimState sim = {};
+    simInit(&sim, &world);
+    Player& player = sim.player;
+    // Player position before the last tick, used to interpolate drawing between ticks.
+    Vector2 prevPlayerPosition = player.position;
+    // Time which wasn't simulated yet.
+    float tickAccumulator = 0.0f;
+
+    // Autotile sprites of the screens around the player, streamed in on a worker thread
+    ScreenCache* screenCache = screenCacheCreate(&world, SCREEN_CACHE_CAPACITY);
 
     Texture playerTexture = LoadTexture("player.png");
     Texture tilemapTexture = LoadTexture("tilemap.png");
 
     RenderTexture pixelartRenderTexture = LoadRenderTexture(VIEW_PIXELS_X, VIEW_PIXELS_Y);
 
+    StaticLayerCache staticLayers[STATIC_LAYER_COUNT] = {};
+    for (int i = 0; i < STATIC_LAYER_COUNT; i++) {
+        staticLayers[i].texture = LoadRenderTexture(VIEW_PIXELS_X, VIEW_PIXELS_Y);
+    }
+    uint64_t frameIndex = 0;
+    // Big enough for every tile on a screen
+    SpriteBatch tileBatch = {};
+    spriteBatchInit(&tileBatch, TILEMAP_SIZE_X * TILEMAP_SIZE_Y);
+    SpriteBatch ghostBatch = {};
+    spriteBatchInit(&ghostBatch, GHOST_BATCH_CAPACITY);
+
+    LevelWatch* levelWatch = levelPath && isWatchingLevel ? levelWatchStart(levelPath) : NULL;
+
     // Main game loop
     // --------------
 
     // `WindowShouldClose` detects window close
     while (!WindowShouldClose()) {
-        const float delta = Clamp(GetFrameTime(), 0.0001f, 0.1f);
-
-        int screenIndex = arrayNumItems(screenTilemaps) - getScreenHeightIndex(player.position.y) - 2;
-        if (screenIndex < 0 || screenIndex > arrayNumItems(screenTilemaps)) screenIndex = 0;
-
-        const Tilemap* tilemap = &screenTilemaps[screenIndex % arrayNumItems(screenTilemaps)];
-        const int heightIndex = getScreenHeightIndex(player.position.y);
-        const float screenOffsetY = -(float)(heightIndex + 1) * TILEMAP_SIZE_Y;
+        profilerBeginFrame();
+        TRACE_SCOPE("frame");
+        const float delta = Clamp(GetFrameTime(), 0.0001f, 0.25f);
+
+        // Level was edited on disk
+        LevelFile newLevelFile = {};
+        if (levelWatch && levelWatchTakeUpdate(levelWatch, &newLevelFile)) {
+            swapLevel(&world, &levelFile, &newLevelFile, screenCache, staticLayers, &ghosts);
+        }
 
         // Update
         {
-            if (IsKeyPressed(KEY_I)) isDebugEnabled = !isDebugEnabled;
-            updatePlayer(&player, tilemap, screenOffsetY, delta);
-            resolveBoxCollisionWithTilemap(tilemap, screenOffsetY, &player.position, &player.velocity, PLAYER_SIZE);
+            if (IsKeyPressed(KEY_I)) {
+                isDebugEnabled = !isDebugEnabled;
+                profilerSetEnabled(isDebugEnabled);
+            }
+
+            // Run as many fixed ticks as fit into the elapsed time.
+            // Input is sampled once per frame; key presses and releases are still
+            // only seen by the first tick, because the simulation tracks previous input.
+            const Input input = readInput();
+            tickAccumulator += delta;
+            int numSubsteps = 0;
+            while (tickAccumulator >= SIM_TICK_DELTA && numSubsteps < maxSubsteps) {
+                prevPlayerPosition = player.position;
+                if (recorder.file) replayRecord(&recorder, input, SIM_TICK_DELTA);
+                simStep(&sim, input, SIM_TICK_DELTA);
+                tickAccumulator -= SIM_TICK_DELTA;
+                numSubsteps++;
+            }
+            // Hit the substep limit, drop the time we couldn't simulate.
+            if (numSubsteps == maxSubsteps) tickAccumulator = fminf(tickAccumulator, SIM_TICK_DELTA);
 
             // Minimum window size
             if (GetScreenWidth() < VIEW_PIXELS_X) {
@@ -439,9 +438,46 @@ int main(int argc, const char** argv) {
             }
 
             if(isDebugEnabled) {
-                // Move screens
+                // Move screens (note: this isn't an input, so it doesn't end up in recorded replays)
                 if (IsKeyPressed(KEY_PAGE_UP)) player.position.y -= TILEMAP_SIZE_Y;
                 if (IsKeyPressed(KEY_PAGE_DOWN)) player.position.y += TILEMAP_SIZE_Y;
+                if (IsKeyPressed(KEY_PAGE_UP) || IsKeyPressed(KEY_PAGE_DOWN)) prevPlayerPosition = player.position;
+            }
+        }
+
+        // The camera shows one whole screen at a time, the one the player is in.
+        const float screenOffsetY = -(float)(getScreenHeightIndex(player.position.y) + 1) * TILEMAP_SIZE_Y;
+        // First row of the world grid on the screen
+        const int screenRow = worldGetRowAtHeight(&world, screenOffsetY);
+        const int screenIndex = screenRow / TILEMAP_SIZE_Y;
+        // Where to draw the player: blend the last two ticks by the not-yet-simulated fraction of a tick.
+        const Vector2 playerDrawPosition = Vector2Lerp(prevPlayerPosition, player.position, tickAccumulator / SIM_TICK_DELTA);
+
+        // Stream in the screens around the player
+        spriteBatchResetStats(&tileBatch);
+        spriteBatchResetStats(&ghostBatch);
+        StaticLayerCache* staticLayer = findStaticLayer(staticLayers, screenIndex);
+        {
+            PROFILE_SCOPE(PROFILE_TILES);
+            AutotileSprite sprites[SCREEN_CACHE_SPRITES];
+
+            // Only happens if the screen wasn't baked ahead of time (e.g. on the first frame)
+            if (!staticLayer) {
+                staticLayer = getFreeStaticLayer(staticLayers, -1);
+                const bool isInWorld = screenCacheGetSprites(screenCache, screenIndex, sprites);
+                bakeStaticLayer(staticLayer, &tileBatch, &world, isInWorld ? sprites : NULL, tilemapTexture, screenIndex);
+            }
+            staticLayer->lastUsedFrame = frameIndex;
+
+            screenCachePrefetch(screenCache, screenIndex - 1);
+            screenCachePrefetch(screenCache, screenIndex + 1);
+
+            // Bake a neighbor once the worker loaded it, at most one per frame
+            const int neighbors[] = { screenIndex - 1, screenIndex + 1 };
+            for (int neighbor : neighbors) {
+                if (findStaticLayer(staticLayers, neighbor) || !screenCacheTryGetSprites(screenCache, neighbor, sprites)) continue;
+                bakeStaticLayer(getFreeStaticLayer(staticLayers, screenIndex), &tileBatch, &world, sprites, tilemapTexture, neighbor);
+                break;
             }
         }
 
@@ -450,100 +486,41 @@ int main(int argc, const char** argv) {
             BeginTextureMode(pixelartRenderTexture);
             ClearBackground(BACKGROUND_COLOR);
 
-            // Draw tilemap
-            for (int x = 0; x < TILEMAP_SIZE_X; x++) {
-                for (int y = 0; y < TILEMAP_SIZE_Y; y++) {
-                    if (!tilemapIsTileFull(tilemap, x, y)) continue;
-                    // DrawRectangle(x * TILE_PIXELS, y * TILE_PIXELS, TILE_PIXELS, TILE_PIXELS, ORANGE);
-
-                    const Tile tile = tilemapGetTileFullOutside(tilemap, x, y);
-                    // Neighbors
-                    const Tile top = tilemapGetTileFullOutside(tilemap, x, y - 1);
-                    const Tile bottom = tilemapGetTileFullOutside(tilemap, x, y + 1);
-                    const Tile right = tilemapGetTileFullOutside(tilemap, x + 1, y);
-                    const Tile left = tilemapGetTileFullOutside(tilemap, x - 1, y);
-                    const Tile topRight = tilemapGetTileFullOutside(tilemap, x + 1, y - 1);
-                    const Tile bottomRight = tilemapGetTileFullOutside(tilemap, x + 1, y + 1);
-                    const Tile topLeft = tilemapGetTileFullOutside(tilemap, x - 1, y - 1);
-                    const Tile bottomLeft = tilemapGetTileFullOutside(tilemap, x - 1, y + 1);
-
-                    int spriteX = 0;
-                    int spriteY = 0;
-
-                    // This logic is bit of a hack...
-                    switch (tile) {
-                    case TILE_FULL: {
-                        spriteX = 1;
-                        spriteY = 1;
-                        if (top == TILE_FULL) spriteY += 1;
-                        if (bottom == TILE_FULL) spriteY -= 1;
-                        if (right == TILE_FULL) spriteX -= 1;
-                        if (left == TILE_FULL) spriteX += 1;
-
-                        if (top != TILE_FULL && bottom != TILE_FULL && right != TILE_FULL && left != TILE_FULL) {
-                            spriteX = 3;
-                            spriteY = 3;
-                        }
-
-                        if (left != TILE_FULL && right != TILE_FULL && spriteX == 1) spriteX = 3;
-                        if (top != TILE_FULL && bottom != TILE_FULL && spriteY == 1) spriteY = 3;
-
-                        if (spriteX == 1 && spriteY == 1) {
-                            if (topRight != TILE_FULL && bottomRight == TILE_FULL &&
-                                topLeft == TILE_FULL && bottomLeft == TILE_FULL) {
-                                spriteX = 4;
-                                spriteY = 2;
-                            }
-
-                            if (topRight == TILE_FULL && bottomRight != TILE_FULL &&
-                                topLeft == TILE_FULL && bottomLeft == TILE_FULL) {
-                                spriteX = 4;
-                                spriteY = 0;
-                            }
-
-                            if (topRight == TILE_FULL && bottomRight == TILE_FULL &&
-                                topLeft != TILE_FULL && bottomLeft == TILE_FULL) {
-                                spriteX = 6;
-                                spriteY = 2;
-                            }
-
-                            if (topRight == TILE_FULL && bottomRight == TILE_FULL &&
-                                topLeft == TILE_FULL && bottomLeft != TILE_FULL) {
-                                spriteX = 6;
-                                spriteY = 0;
-                            }
-                        }
-
-                    } break;
-                    }
+            // Draw tiles (the background color is baked in as well)
+            {
+                PROFILE_SCOPE(PROFILE_TILES);
+                const Texture staticTexture = staticLayer->texture.texture;
+                DrawTextureRec(staticTexture, { 0, 0, (float)staticTexture.width, -(float)staticTexture.height }, {}, WHITE);
+            }
 
-                    drawSpriteSheetTile(tilemapTexture, spriteX, spriteY, TILE_PIXELS, { (float)x * TILE_PIXELS, (float)y * TILE_PIXELS });
+            // Draw ghosts on the current screen, at the same point of their runs as the player (blended the same way)
+            if (ghosts.count > 0) {
+                PROFILE_SCOPE(PROFILE_GHOSTS);
+                ghostsUpdate(&ghosts, sim.tick > 0 ? sim.tick - 1 : 0, sim.tick > 0 ? tickAccumulator / SIM_TICK_DELTA : 0.0f);
+
+                spriteBatchBegin(&ghostBatch, playerTexture);
+                for (int i = 0; i < ghosts.count; i++) {
+                    const Vector2 position = ghosts.positions[i];
+                    if (position.y < screenOffsetY - 1 || position.y > screenOffsetY + TILEMAP_SIZE_Y + 1) continue;
+
+                    const uint8_t sprite = ghosts.sprites[i];
+                    spriteBatchAdd(
+                        &ghostBatch,
+                        { (float)((sprite & ~GHOST_SPRITE_FLIPPED) * 16), 0, 16, 16 },
+                        Vector2Subtract(worldToScreen({ position.x, position.y - screenOffsetY }), { 8, 10 }),
+                        (sprite & GHOST_SPRITE_FLIPPED) != 0,
+                        GHOST_TINT);
                 }
+                spriteBatchEnd(&ghostBatch);
             }
 
             // Draw player, but relative to current screen
             {
-                int sprite = 0;
-
+                PROFILE_SCOPE(PROFILE_PLAYER);
                 player.animTime += delta;
+                const int sprite = getPlayerSprite(&player);
 
-                // Pick an sprite/animation based on player state
-                if (player.isOnGround) {
-                    sprite = 0;
-
-                    if (fabsf(player.velocity.x) > 0.01) {
-                        sprite = 1 + ((int)floorf(player.animTime * 6.0f)) % 2;
-                    }
-
-                    if (player.jumpHoldTime > 0.001) {
-                        sprite = 4;
-                    }
-                }
-                else {
-                    sprite = player.velocity.y > 0 ? 5 : 6;
-                }
-
-                drawSpriteSheetTile(playerTexture, sprite, 0, 16, Vector2Subtract(worldToScreen({ player.position.x, player.position.y - screenOffsetY}), { 8, 10 }), {(float)(player.isFacingRight ? 1 : -1), 1});
+                drawSpriteSheetTile(playerTexture, sprite, 0, 16, Vector2Subtract(worldToScreen({ playerDrawPosition.x, playerDrawPosition.y - screenOffsetY}), { 8, 10 }), {(float)(player.isFacingRight ? 1 : -1), 1});
             }
 
             EndTextureMode();
@@ -559,17 +536,20 @@ int main(int argc, const char** argv) {
             const Vector2 size = { scale * VIEW_PIXELS_X, scale * VIEW_PIXELS_Y };
             const Vector2 offset = Vector2Scale(Vector2Subtract(window, size), 0.5);
 
-            DrawTexturePro(
-                pixelartRenderTexture.texture,
-                { 0, 0, (float)pixelartRenderTexture.texture.width, -(float)pixelartRenderTexture.texture.height },
-                { offset.x, offset.y, size.x, size.y },
-                {}, 0, WHITE);
+            {
+                PROFILE_SCOPE(PROFILE_UPSCALE);
+                DrawTexturePro(
+                    pixelartRenderTexture.texture,
+                    { 0, 0, (float)pixelartRenderTexture.texture.width, -(float)pixelartRenderTexture.texture.height },
+                    { offset.x, offset.y, size.x, size.y },
+                    {}, 0, WHITE);
+            }
 
             if (isDebugEnabled) {
                 // Draw tilemap debug info
                 for (int x = 0; x < TILEMAP_SIZE_X; x++) {
                     for (int y = 0; y < TILEMAP_SIZE_Y; y++) {
-                        Tile tile = tilemapGetTile(tilemap, x, y);
+                        Tile tile = worldGetTile(&world, x, screenRow + y);
                         DrawTextEx(GetFontDefault(), TextFormat("[%i,%i]\n%i\n\'%c\'", x, y, tile, tile),
                             Vector2Add(worldToScreen(Vector2{ (float)x * scale, (float)y * scale }), Vector2Add(offset, { 3, 3 })),
                             10, 1, RED);
@@ -606,14 +586,32 @@ int main(int argc, const char** argv) {
                 DrawText(TextFormat("player.jumpHoldTime = %f", player.jumpHoldTime), 1, 88, 20, WHITE);
                 DrawText(TextFormat("screenOffset = %f", screenOffsetY), 1, 22 * 6, 20, WHITE);
                 DrawText(TextFormat("screenIndex = %i", screenIndex), 1, 22 * 7, 20, WHITE);
+                DrawText(TextFormat("tile quads = %i (%i draws)", tileBatch.numQuads, tileBatch.numDraws), 1, 22 * 8, 20, WHITE);
+                const ScreenCacheStats screenStats = screenCacheGetStats(screenCache);
+                DrawText(TextFormat("screens resident = %i (misses %i, prefetched %i, evicted %i)",
+                    screenStats.numResident, screenStats.numMisses, screenStats.numPrefetched, screenStats.numEvicted), 1, 22 * 9, 20, WHITE);
+                DrawText(TextFormat("ghosts = %i (%i on screen, %i draws)", ghosts.count, ghostBatch.numQuads, ghostBatch.numDraws), 1, 22 * 10, 20, WHITE);
+                drawProfilerOverlay(1, 22 * 11);
             }
 
+            PROFILE_SCOPE(PROFILE_PRESENT);
             EndDrawing();
         }
+
+        frameIndex++;
     }
 
     // Shutdown
 
+    replayRecorderClose(&recorder);
+    traceStop();
+    spriteBatchFree(&tileBatch);
+    spriteBatchFree(&ghostBatch);
+    ghostsFree(&ghosts);
+    levelWatchStop(levelWatch);
+    screenCacheDestroy(screenCache);
+    worldFree(&world);
+    levelFileClose(&levelFile);
     CloseWindow(); // Close window and OpenGL context
 
     return 0;
@@ -0,0 +1,447 @@
+// Null platform
+// -------------
+// Stand-in for the parts of raylib (and rlgl) the game uses, for machines without a GPU or display.
+// Linking the unmodified `main.cpp` against this instead of raylib runs the whole game loop
+// at full CPU speed: input comes from a script, draw calls are only counted (and optionally logged),
+// and the cost of every frame is measured. Used for soak tests and frame cost measurements.
+//
+// Configured with environment variables:
+//  JUMP_PRINCE_SCRIPT      input script, lines of "<number of frames> [KEY ...]" (keys held during those frames),
+//                          e.g. "60 SPACE RIGHT". Lines starting with '#' are comments.
+//  JUMP_PRINCE_FRAMES      number of frames to run (default: length of the script, or 600 without a script)
+//  JUMP_PRINCE_FRAME_TIME  value returned by GetFrameTime (default: 1/60)
+//  JUMP_PRINCE_DRAW_LOG    file to write every recorded draw command to
+
+#include "raylib.h"
+#include "rlgl.h"
+#include <stdio.h>
+#include <stdlib.h> // getenv, atoi, atof, malloc, free
+#include <string.h> // strcmp, strlen, memset
+#include <stdarg.h> // va_list
+#ifdef _WIN32
+#include <io.h> // _findfirst (windows.h would clash with raylib's names)
+#else
+#include <dirent.h> // opendir
+#include <sys/stat.h> // stat
+#endif
+#include <chrono>
+
+// Kinds of draw commands we record
+enum DrawCommand {
+    DRAW_CLEAR,
+    DRAW_TEXTURE_REC,
+    DRAW_TEXTURE_PRO,
+    DRAW_RECTANGLE,
+    DRAW_TEXT,
+    DRAW_RLGL_VERTEX,
+    DRAW_RLGL_BATCH,
+    DRAW_COMMAND_COUNT,
+};
+
+static const char* drawCommandNames[DRAW_COMMAND_COUNT] = {
+    "ClearBackground",
+    "DrawTextureRec",
+    "DrawTexturePro",
+    "DrawRectangle",
+    "DrawText",
+    "rlVertex",
+    "rlgl batch draw",
+};
+
+// Keys held for a number of frames
+struct ScriptStep {
+    int numFrames;
+    int numKeys;
+    int keys[8];
+};
+
+static struct {
+    int screenWidth;
+    int screenHeight;
+    float frameTime;
+    int numFrames;
+    int frame;
+
+    ScriptStep* script;
+    int numScriptSteps;
+
+    bool isKeyDown[512];
+    bool wasKeyDown[512];
+
+    unsigned int nextTextureId;
+
+    FILE* drawLog;
+    uint64_t drawCounts[DRAW_COMMAND_COUNT];
+    int pendingVertices;
+
+    double frameStart;
+    double frameCostSum;
+    double frameCostMin;
+    double frameCostMax;
+} platform;
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void recordDraw(DrawCommand command, const char* format = NULL, ...) {
+    platform.drawCounts[command]++;
+    if (!platform.drawLog) return;
+
+    fprintf(platform.drawLog, "%i %s", platform.frame, drawCommandNames[command]);
+    if (format) {
+        va_list args;
+        va_start(args, format);
+        fputc(' ', platform.drawLog);
+        vfprintf(platform.drawLog, format, args);
+        va_end(args);
+    }
+    fputc('\n', platform.drawLog);
+}
+
+static int keyFromName(const char* name) {
+    static const struct { const char* name; int key; } keys[] = {
+        { "SPACE", KEY_SPACE }, { "LEFT", KEY_LEFT }, { "RIGHT", KEY_RIGHT }, { "UP", KEY_UP }, { "DOWN", KEY_DOWN },
+        { "A", KEY_A }, { "D", KEY_D }, { "I", KEY_I }, { "PAGE_UP", KEY_PAGE_UP }, { "PAGE_DOWN", KEY_PAGE_DOWN },
+    };
+    for (int i = 0; i < (int)(sizeof(keys) / sizeof(keys[0])); i++) {
+        if (strcmp(keys[i].name, name) == 0) return keys[i].key;
+    }
+    return KEY_NULL;
+}
+
+static void loadScript(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("null platform: failed to open script '%s'\n", path);
+        return;
+    }
+
+    int capacity = 64;
+    platform.script = (ScriptStep*)malloc(sizeof(ScriptStep) * capacity);
+
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+
+        ScriptStep step = {};
+        char* token = strtok(line, " \t\r\n");
+        if (!token) continue;
+        step.numFrames = atoi(token);
+        while ((token = strtok(NULL, " \t\r\n")) && step.numKeys < (int)(sizeof(step.keys) / sizeof(step.keys[0]))) {
+            const int key = keyFromName(token);
+            if (key == KEY_NULL) printf("null platform: unknown key '%s'\n", token);
+            else step.keys[step.numKeys++] = key;
+        }
+
+        if (platform.numScriptSteps == capacity) {
+            capacity *= 2;
+            platform.script = (ScriptStep*)realloc(platform.script, sizeof(ScriptStep) * capacity);
+        }
+        platform.script[platform.numScriptSteps++] = step;
+    }
+
+    fclose(file);
+}
+
+// Set the held keys for the current frame from the script.
+static void updateScriptedInput() {
+    memcpy(platform.wasKeyDown, platform.isKeyDown, sizeof(platform.isKeyDown));
+    memset(platform.isKeyDown, 0, sizeof(platform.isKeyDown));
+
+    int frame = platform.frame;
+    for (int i = 0; i < platform.numScriptSteps; i++) {
+        const ScriptStep* step = &platform.script[i];
+        if (frame >= step->numFrames) {
+            frame -= step->numFrames;
+            continue;
+        }
+        for (int k = 0; k < step->numKeys; k++) platform.isKeyDown[step->keys[k]] = true;
+        break;
+    }
+}
+
+// Window
+// ------
+
+void InitWindow(int width, int height, const char* title) {
+    platform.screenWidth = width;
+    platform.screenHeight = height;
+    platform.nextTextureId = 1;
+    platform.frameCostMin = 1e9;
+
+    const char* frameTime = getenv("JUMP_PRINCE_FRAME_TIME");
+    platform.frameTime = frameTime ? (float)atof(frameTime) : 1.0f / 60.0f;
+
+    const char* script = getenv("JUMP_PRINCE_SCRIPT");
+    if (script) loadScript(script);
+
+    int scriptFrames = 0;
+    for (int i = 0; i < platform.numScriptSteps; i++) scriptFrames += platform.script[i].numFrames;
+    const char* numFrames = getenv("JUMP_PRINCE_FRAMES");
+    platform.numFrames = numFrames ? atoi(numFrames) : (scriptFrames > 0 ? scriptFrames : 600);
+
+    const char* drawLog = getenv("JUMP_PRINCE_DRAW_LOG");
+    if (drawLog) platform.drawLog = fopen(drawLog, "w");
+
+    printf("null platform: '%s' %ix%i, %i frames\n", title, width, height, platform.numFrames);
+    updateScriptedInput();
+    platform.frameStart = nowSeconds();
+}
+
+bool WindowShouldClose(void) {
+    return platform.frame >= platform.numFrames;
+}
+
+void CloseWindow(void) {
+    const int numFrames = platform.frame > 0 ? platform.frame : 1;
+    printf("null platform: %i frames, frame cost avg %.3f us, min %.3f us, max %.3f us\n",
+        platform.frame, platform.frameCostSum * 1e6 / numFrames, platform.frameCostMin * 1e6, platform.frameCostMax * 1e6);
+    for (int i = 0; i < DRAW_COMMAND_COUNT; i++) {
+        printf("  %-20s %12llu total %10.2f per frame\n",
+            drawCommandNames[i], (unsigned long long)platform.drawCounts[i], (double)platform.drawCounts[i] / numFrames);
+    }
+
+    if (platform.drawLog) fclose(platform.drawLog);
+    free(platform.script);
+    platform = {};
+}
+
+void SetConfigFlags(unsigned int) {}
+void SetTargetFPS(int) {}
+void SetExitKey(int) {}
+int GetScreenWidth(void) { return platform.screenWidth; }
+int GetScreenHeight(void) { return platform.screenHeight; }
+
+void SetWindowSize(int width, int height) {
+    platform.screenWidth = width;
+    platform.screenHeight = height;
+}
+
+float GetFrameTime(void) { return platform.frameTime; }
+bool ChangeDirectory(const char*) { return true; }
+
+// Input
+// -----
+
+bool IsKeyDown(int key) { return key > 0 && key < 512 && platform.isKeyDown[key]; }
+bool IsKeyUp(int key) { return !IsKeyDown(key); }
+bool IsKeyPressed(int key) { return IsKeyDown(key) && !platform.wasKeyDown[key]; }
+bool IsKeyReleased(int key) { return key > 0 && key < 512 && !platform.isKeyDown[key] && platform.wasKeyDown[key]; }
+
+// Drawing
+// -------
+
+void BeginDrawing(void) {}
+
+void EndDrawing(void) {
+    const double now = nowSeconds();
+    const double cost = now - platform.frameStart;
+    platform.frameCostSum += cost;
+    if (cost < platform.frameCostMin) platform.frameCostMin = cost;
+    if (cost > platform.frameCostMax) platform.frameCostMax = cost;
+    platform.frameStart = now;
+
+    // Next frame, like raylib polling input events at the end of the frame
+    platform.frame++;
+    updateScriptedInput();
+}
+
+void BeginTextureMode(RenderTexture2D) {}
+void EndTextureMode(void) {}
+
+void ClearBackground(Color color) {
+    recordDraw(DRAW_CLEAR, "%i %i %i %i", color.r, color.g, color.b, color.a);
+}
+
+void DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color) {
+    recordDraw(DRAW_TEXTURE_REC, "tex=%u src=[%g %g %g %g] pos=[%g %g]",
+        texture.id, source.x, source.y, source.width, source.height, position.x, position.y);
+}
+
+void DrawTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Vector2, float, Color) {
+    recordDraw(DRAW_TEXTURE_PRO, "tex=%u src=[%g %g %g %g] dest=[%g %g %g %g]",
+        texture.id, source.x, source.y, source.width, source.height, dest.x, dest.y, dest.width, dest.height);
+}
+
+void DrawRectangle(int posX, int posY, int width, int height, Color) {
+    recordDraw(DRAW_RECTANGLE, "[%i %i %i %i]", posX, posY, width, height);
+}
+
+void DrawText(const char* text, int, int, int, Color) {
+    recordDraw(DRAW_TEXT, "%s", text);
+}
+
+void DrawTextEx(Font, const char* text, Vector2, float, float, Color) {
+    recordDraw(DRAW_TEXT, "%s", text);
+}
+
+void DrawFPS(int, int) {
+    recordDraw(DRAW_TEXT, "FPS");
+}
+
+Font GetFontDefault(void) { return Font{}; }
+
+Color Fade(Color color, float alpha) {
+    color.a = (unsigned char)(255.0f * (alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha)));
+    return color;
+}
+
+// Textures
+// --------
+
+Texture2D LoadTexture(const char* fileName) {
+    Texture2D texture = {};
+    texture.id = platform.nextTextureId++;
+    texture.width = 1;
+    texture.height = 1;
+    texture.mipmaps = 1;
+
+    // Read the size from the PNG header (if there is one), the pixels aren't needed.
+    FILE* file = fopen(fileName, "rb");
+    if (file) {
+        unsigned char header[24] = {};
+        if (fread(header, 1, sizeof(header), file) == sizeof(header) && header[1] == 'P' && header[2] == 'N' && header[3] == 'G') {
+            texture.width = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+            texture.height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+        }
+        fclose(file);
+    }
+    return texture;
+}
+
+RenderTexture2D LoadRenderTexture(int width, int height) {
+    RenderTexture2D target = {};
+    target.id = platform.nextTextureId++;
+    target.texture.id = platform.nextTextureId++;
+    target.texture.width = width;
+    target.texture.height = height;
+    target.texture.mipmaps = 1;
+    return target;
+}
+
+void UnloadTexture(Texture2D) {}
+void UnloadRenderTexture(RenderTexture2D) {}
+
+// Text
+// ----
+
+const char* TextFormat(const char* text, ...) {
+    // Like raylib, a few static buffers used round-robin
+    static char buffers[4][1024];
+    static int index = 0;
+    char* buffer = buffers[index];
+    index = (index + 1) % 4;
+
+    va_list args;
+    va_start(args, text);
+    vsnprintf(buffer, sizeof(buffers[0]), text, args);
+    va_end(args);
+    return buffer;
+}
+
+const char** TextSplit(const char* text, char delimiter, int* count) {
+    static char buffer[1024];
+    static const char* parts[128];
+
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    int numParts = 1;
+    parts[0] = buffer;
+    for (char* c = buffer; *c && numParts < 128; c++) {
+        if (*c != delimiter) continue;
+        *c = '\0';
+        parts[numParts++] = c + 1;
+    }
+    *count = numParts;
+    return parts;
+}
+
+const char* TextJoin(const char** textList, int count, const char* delimiter) {
+    static char buffer[1024];
+    buffer[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        if (i > 0) strncat(buffer, delimiter, sizeof(buffer) - strlen(buffer) - 1);
+        strncat(buffer, textList[i], sizeof(buffer) - strlen(buffer) - 1);
+    }
+    return buffer;
+}
+
+int TextToInteger(const char* text) {
+    return atoi(text);
+}
+
+// Files
+// -----
+
+static void addDirectoryFile(FilePathList* files, const char* dirPath, const char* name) {
+    if (files->count == files->capacity) {
+        files->capacity = files->capacity > 0 ? files->capacity * 2 : 64;
+        files->paths = (char**)realloc(files->paths, sizeof(char*) * files->capacity);
+    }
+    const size_t size = strlen(dirPath) + strlen(name) + 2;
+    char* path = (char*)malloc(size);
+    snprintf(path, size, "%s/%s", dirPath, name);
+    files->paths[files->count++] = path;
+}
+
+// Like raylib, full paths of the files in the directory (not recursive). Subdirectories are left out.
+FilePathList LoadDirectoryFiles(const char* dirPath) {
+    FilePathList files = {};
+#ifdef _WIN32
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dirPath);
+    _finddata_t data = {};
+    const intptr_t find = _findfirst(pattern, &data);
+    if (find == -1) return files;
+    do {
+        if (!(data.attrib & _A_SUBDIR)) addDirectoryFile(&files, dirPath, data.name);
+    } while (_findnext(find, &data) == 0);
+    _findclose(find);
+#else
+    DIR* dir = opendir(dirPath);
+    if (!dir) return files;
+    while (const dirent* entry = readdir(dir)) {
+        char path[1024];
+        struct stat info = {};
+        snprintf(path, sizeof(path), "%s/%s", dirPath, entry->d_name);
+        if (stat(path, &info) == 0 && S_ISREG(info.st_mode)) addDirectoryFile(&files, dirPath, entry->d_name);
+    }
+    closedir(dir);
+#endif
+    return files;
+}
+
+void UnloadDirectoryFiles(FilePathList files) {
+    for (unsigned int i = 0; i < files.count; i++) free(files.paths[i]);
+    free(files.paths);
+}
+
+// rlgl
+// ----
+
+rlRenderBatch rlLoadRenderBatch(int, int) {
+    return rlRenderBatch{};
+}
+
+void rlUnloadRenderBatch(rlRenderBatch) {}
+
+void rlDrawRenderBatchActive(void) {
+    if (platform.pendingVertices == 0) return;
+    recordDraw(DRAW_RLGL_BATCH, "%i vertices", platform.pendingVertices);
+    platform.pendingVertices = 0;
+}
+
+void rlSetRenderBatchActive(rlRenderBatch*) {
+    rlDrawRenderBatchActive();
+}
+
+void rlSetTexture(unsigned int) {}
+void rlBegin(int) {}
+void rlEnd(void) {}
+void rlColor4ub(unsigned char, unsigned char, unsigned char, unsigned char) {}
+void rlTexCoord2f(float, float) {}
+
+void rlVertex2f(float, float) {
+    platform.drawCounts[DRAW_RLGL_VERTEX]++;
+    platform.pendingVertices++;
+}
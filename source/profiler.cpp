@@ -0,0 +1,94 @@
+#include "profiler.h"
+#include <string.h> // memset
+#include <algorithm> // std::nth_element
+#include <chrono>
+
+bool isProfilerEnabled = false;
+thread_local bool isProfilerThread = false;
+
+static const char* phaseNames[PROFILE_PHASE_COUNT] = {
+    "input",
+    "updatePlayer",
+    "collision",
+    "tiles",
+    "ghosts",
+    "player",
+    "upscale",
+    "present",
+    "frame",
+};
+
+static struct {
+    // Nanoseconds spent in every phase during the current frame
+    uint64_t current[PROFILE_PHASE_COUNT];
+    uint64_t frameStartTime;
+
+    // Ring buffer of finished frames (microseconds), `head` is where the next one goes
+    float history[PROFILE_PHASE_COUNT][PROFILER_HISTORY_FRAMES];
+    int head;
+    int numFrames;
+} profiler;
+
+uint64_t profilerNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void profilerAdd(ProfilePhase phase, uint64_t startTime) {
+    profiler.current[phase] += profilerNow() - startTime;
+}
+
+void profilerSetEnabled(bool isEnabled) {
+    if (isEnabled && !isProfilerEnabled) memset(&profiler, 0, sizeof(profiler));
+    isProfilerThread = true;
+    isProfilerEnabled = isEnabled;
+}
+
+void profilerBeginFrame() {
+    if (!isProfilerEnabled) return;
+
+    const uint64_t now = profilerNow();
+    if (profiler.frameStartTime != 0) {
+        profiler.current[PROFILE_FRAME] = now - profiler.frameStartTime;
+        for (int i = 0; i < PROFILE_PHASE_COUNT; i++) {
+            profiler.history[i][profiler.head] = (float)profiler.current[i] * 1e-3f;
+        }
+        profiler.head = (profiler.head + 1) % PROFILER_HISTORY_FRAMES;
+        if (profiler.numFrames < PROFILER_HISTORY_FRAMES) profiler.numFrames++;
+    }
+
+    memset(profiler.current, 0, sizeof(profiler.current));
+    profiler.frameStartTime = now;
+}
+
+const char* profilerGetPhaseName(ProfilePhase phase) {
+    return phaseNames[phase];
+}
+
+ProfileStats profilerGetStats(ProfilePhase phase) {
+    ProfileStats stats = {};
+    float times[PROFILER_HISTORY_FRAMES] = {};
+    const int numFrames = profilerGetHistory(phase, times);
+    if (numFrames == 0) return stats;
+
+    float sum = 0.0f;
+    stats.min = times[0];
+    for (int i = 0; i < numFrames; i++) {
+        sum += times[i];
+        if (times[i] < stats.min) stats.min = times[i];
+    }
+    stats.avg = sum / numFrames;
+
+    // Smallest time which at least 99% of the frames are at or below
+    const int p99Index = (numFrames * 99 + 99) / 100 - 1;
+    std::nth_element(times, times + p99Index, times + numFrames);
+    stats.p99 = times[p99Index];
+    return stats;
+}
+
+int profilerGetHistory(ProfilePhase phase, float* outTimes) {
+    const int oldest = (profiler.head - profiler.numFrames + PROFILER_HISTORY_FRAMES) % PROFILER_HISTORY_FRAMES;
+    for (int i = 0; i < profiler.numFrames; i++) {
+        outTimes[i] = profiler.history[phase][(oldest + i) % PROFILER_HISTORY_FRAMES];
+    }
+    return profiler.numFrames;
+}
@@ -0,0 +1,72 @@
+// Frame profiler
+// --------------
+// Scoped timers around the phases of a frame (input, simulation, drawing, present), summed up per frame
+// and kept for the last PROFILER_HISTORY_FRAMES frames, so the debug overlay can show min/avg/p99 of every phase
+// and a graph of frame times.
+//
+// A scope is two reads of the steady clock (tens of nanoseconds), and nothing at all while the profiler is disabled.
+// The profiler is global and only records on the thread which enabled it (the game's main thread),
+// so scopes in code shared with worker threads (e.g. `simStep` baking ghosts) are no-ops there.
+#pragma once
+
+#include "trace.h"
+#include <stdint.h>
+
+// Frames the stats and the graph are computed over (4 seconds at 60 FPS)
+#define PROFILER_HISTORY_FRAMES 240
+
+enum ProfilePhase {
+    PROFILE_INPUT,
+    PROFILE_UPDATE_PLAYER,
+    PROFILE_COLLISION,
+    PROFILE_TILES,
+    PROFILE_GHOSTS,
+    PROFILE_PLAYER,
+    PROFILE_UPSCALE,
+    PROFILE_PRESENT,
+    // Whole frame, from one `profilerBeginFrame` to the next
+    PROFILE_FRAME,
+    PROFILE_PHASE_COUNT,
+};
+
+// In microseconds, over the frames in the history
+struct ProfileStats {
+    float min;
+    float avg;
+    float p99;
+};
+
+extern bool isProfilerEnabled;
+// Set on the thread which called `profilerSetEnabled`, scopes on every other thread don't record anything
+extern thread_local bool isProfilerThread;
+
+// Nanoseconds from the steady clock
+uint64_t profilerNow();
+// Add time to the phase in the current frame (phases can run many times per frame, e.g. once per tick).
+void profilerAdd(ProfilePhase phase, uint64_t startTime);
+
+// Enabling starts with an empty history, and makes the calling thread the one which is profiled.
+void profilerSetEnabled(bool isEnabled);
+// Ends the previous frame (stores its phases into the history) and starts a new one.
+void profilerBeginFrame();
+
+const char* profilerGetPhaseName(ProfilePhase phase);
+ProfileStats profilerGetStats(ProfilePhase phase);
+// Times of the phase in the history (microseconds), oldest first. Returns the number of frames.
+int profilerGetHistory(ProfilePhase phase, float* outTimes);
+
+// Times the rest of the C++ scope, e.g. `PROFILE_SCOPE(PROFILE_TILES);`. Also shows up in traces (see `trace.h`).
+struct ProfileScope {
+    ProfilePhase phase;
+    uint64_t startTime;
+
+    // The thread is checked first, so other threads never read the flag while it's being changed
+    explicit ProfileScope(ProfilePhase scopePhase) : phase(scopePhase), startTime(isProfilerThread && isProfilerEnabled ? profilerNow() : 0) {}
+    ~ProfileScope() {
+        if (startTime != 0 && isProfilerEnabled) profilerAdd(phase, startTime);
+    }
+};
+
+#define PROFILE_SCOPE_NAME2(line) profileScope##line
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_NAME2(line)
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_SCOPE_NAME(__LINE__)(phase); TRACE_SCOPE(profilerGetPhaseName(phase))
@@ -0,0 +1,137 @@
+#include "replay.h"
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcmp, memcpy
+
+// Size of a single run in the file. Fields are written one by one, so there's no padding.
+#define REPLAY_RUN_BYTES (sizeof(Input) + sizeof(uint16_t) + sizeof(float))
+#define REPLAY_HEADER_BYTES (4 + sizeof(uint32_t))
+
+static void writeRun(FILE* file, const ReplayRun* run) {
+    fwrite(&run->input, sizeof(run->input), 1, file);
+    fwrite(&run->count, sizeof(run->count), 1, file);
+    fwrite(&run->delta, sizeof(run->delta), 1, file);
+}
+
+bool replayRecorderOpen(ReplayRecorder* recorder, const char* path) {
+    *recorder = {};
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) return false;
+
+    const uint32_t version = REPLAY_VERSION;
+    fwrite(REPLAY_MAGIC, 4, 1, recorder->file);
+    fwrite(&version, sizeof(version), 1, recorder->file);
+    return true;
+}
+
+void replayRecord(ReplayRecorder* recorder, Input input, float delta) {
+    ReplayRun* run = &recorder->run;
+
+    // Merge into the current run if nothing changed.
+    // Delta is compared bit-wise, since it has to be replayed exactly.
+    if (run->count > 0 && run->count < UINT16_MAX &&
+        run->input == input && memcmp(&run->delta, &delta, sizeof(delta)) == 0) {
+        run->count++;
+    }
+    else {
+        if (run->count > 0) writeRun(recorder->file, run);
+        run->input = input;
+        run->delta = delta;
+        run->count = 1;
+    }
+
+    recorder->numTicks++;
+}
+
+void replayRecorderClose(ReplayRecorder* recorder) {
+    if (!recorder->file) return;
+    if (recorder->run.count > 0) writeRun(recorder->file, &recorder->run);
+    fclose(recorder->file);
+    *recorder = {};
+}
+
+bool replayLoad(Replay* replay, const char* path) {
+    *replay = {};
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    const long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (fileSize < (long)REPLAY_HEADER_BYTES) {
+        fclose(file);
+        return false;
+    }
+
+    uint8_t* data = (uint8_t*)malloc(fileSize);
+    const size_t numRead = fread(data, 1, fileSize, file);
+    fclose(file);
+
+    uint32_t version = 0;
+    memcpy(&version, data + 4, sizeof(version));
+    if (numRead != (size_t)fileSize || memcmp(data, REPLAY_MAGIC, 4) != 0 || version != REPLAY_VERSION) {
+        free(data);
+        return false;
+    }
+
+    replay->numRuns = (int)((fileSize - REPLAY_HEADER_BYTES) / REPLAY_RUN_BYTES);
+    replay->runs = (ReplayRun*)malloc(sizeof(ReplayRun) * (replay->numRuns > 0 ? replay->numRuns : 1));
+
+    const uint8_t* read = data + REPLAY_HEADER_BYTES;
+    for (int i = 0; i < replay->numRuns; i++) {
+        ReplayRun* run = &replay->runs[i];
+        memcpy(&run->input, read, sizeof(run->input));
+        read += sizeof(run->input);
+        memcpy(&run->count, read, sizeof(run->count));
+        read += sizeof(run->count);
+        memcpy(&run->delta, read, sizeof(run->delta));
+        read += sizeof(run->delta);
+        replay->numTicks += run->count;
+    }
+
+    free(data);
+    return true;
+}
+
+void replayFree(Replay* replay) {
+    free(replay->runs);
+    *replay = {};
+}
+
+ReplayCursor replayBegin(const Replay* replay) {
+    ReplayCursor cursor = {};
+    cursor.replay = replay;
+    return cursor;
+}
+
+bool replayNext(ReplayCursor* cursor, Input* outInput, float* outDelta) {
+    const Replay* replay = cursor->replay;
+
+    // Skip finished (or empty) runs
+    while (cursor->runIndex < replay->numRuns && cursor->tickInRun >= replay->runs[cursor->runIndex].count) {
+        cursor->runIndex++;
+        cursor->tickInRun = 0;
+    }
+    if (cursor->runIndex >= replay->numRuns) return false;
+
+    const ReplayRun* run = &replay->runs[cursor->runIndex];
+    *outInput = run->input;
+    *outDelta = run->delta;
+    cursor->tickInRun++;
+    return true;
+}
+
+uint64_t replayPlayback(const Replay* replay, const World* world, SimState* state) {
+    simInit(state, world);
+
+    // Iterate the runs directly, this is the hot loop when re-simulating long runs.
+    for (int i = 0; i < replay->numRuns; i++) {
+        const ReplayRun run = replay->runs[i];
+        for (int t = 0; t < run.count; t++) {
+            simStep(state, run.input, run.delta);
+        }
+    }
+
+    return state->tick;
+}
@@ -0,0 +1,60 @@
+// Input replays
+// -------------
+// The simulation is deterministic, so the per-tick input and delta time is all we need
+// to reproduce a run exactly. Replays are stored as a compact binary stream of runs
+// (consecutive ticks with identical input and delta are merged into one record).
+//
+// File layout (little-endian):
+//  header: magic "JPRP" (4 bytes), version (u32)
+//  runs:   input (u8), count (u16), delta (f32) ... until the end of the file
+#pragma once
+
+#include "sim.h"
+#include <stdio.h>
+
+#define REPLAY_MAGIC "JPRP"
+#define REPLAY_VERSION 1u
+
+// A number of consecutive ticks with the same input and delta time.
+struct ReplayRun {
+    Input input;
+    uint16_t count;
+    float delta;
+};
+
+// Writes the replay to a file while the game is running.
+struct ReplayRecorder {
+    FILE* file;
+    ReplayRun run; // Run which is currently being recorded (not written yet)
+    uint64_t numTicks;
+};
+
+// Replay fully loaded into memory.
+struct Replay {
+    ReplayRun* runs;
+    int numRuns;
+    uint64_t numTicks;
+};
+
+// Position inside a replay, used to feed it into the simulation tick by tick.
+struct ReplayCursor {
+    const Replay* replay;
+    int runIndex;
+    int tickInRun;
+};
+
+bool replayRecorderOpen(ReplayRecorder* recorder, const char* path);
+void replayRecord(ReplayRecorder* recorder, Input input, float delta);
+// Flushes the last run and closes the file.
+void replayRecorderClose(ReplayRecorder* recorder);
+
+bool replayLoad(Replay* replay, const char* path);
+void replayFree(Replay* replay);
+
+ReplayCursor replayBegin(const Replay* replay);
+// Get input for the next tick. Returns false once the replay ended.
+bool replayNext(ReplayCursor* cursor, Input* outInput, float* outDelta);
+
+// Re-simulate the whole replay in the `world` as fast as possible, starting from `simInit`.
+// Returns the number of simulated ticks.
+uint64_t replayPlayback(const Replay* replay, const World* world, SimState* state);
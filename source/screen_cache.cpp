@@ -0,0 +1,199 @@
+#include "screen_cache.h"
+#include "trace.h"
+#include <string.h> // memcpy
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ScreenCacheSlot {
+    // -1 if the slot is empty
+    int screenIndex;
+    uint64_t lastUsed;
+    AutotileSprite sprites[SCREEN_CACHE_SPRITES];
+};
+
+struct ScreenCache {
+    const World* world;
+
+    // Guards everything below, except for the world
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<ScreenCacheSlot> slots;
+    std::deque<int> requests;
+    uint64_t useCounter;
+    // Bumped on every invalidation, so a screen loaded from before it isn't installed
+    uint64_t generation;
+    // Screen of the last `screenCacheGetSprites`, the worker never evicts it
+    int pinnedScreen;
+    bool isStopping;
+    ScreenCacheStats stats;
+
+    // Held by the worker while it reads the world, and by the owner while the cache is paused
+    std::mutex worldMutex;
+    std::thread thread;
+};
+
+static int findSlot(const ScreenCache* cache, int screenIndex) {
+    for (int i = 0; i < (int)cache->slots.size(); i++) {
+        if (cache->slots[i].screenIndex == screenIndex) return i;
+    }
+    return -1;
+}
+
+// Put a loaded screen into an empty slot, or evict the least recently used screen (except for the pinned one).
+static void installScreen(ScreenCache* cache, int screenIndex, const AutotileSprite* sprites) {
+    int slotIndex = -1;
+    for (int i = 0; i < (int)cache->slots.size(); i++) {
+        const ScreenCacheSlot* slot = &cache->slots[i];
+        if (slot->screenIndex == -1) {
+            slotIndex = i;
+            break;
+        }
+        if (slot->screenIndex == cache->pinnedScreen) continue;
+        if (slotIndex == -1 || slot->lastUsed < cache->slots[slotIndex].lastUsed) slotIndex = i;
+    }
+    if (slotIndex == -1) return;
+
+    ScreenCacheSlot* slot = &cache->slots[slotIndex];
+    if (slot->screenIndex == -1) cache->stats.numResident++;
+    else cache->stats.numEvicted++;
+
+    slot->screenIndex = screenIndex;
+    slot->lastUsed = ++cache->useCounter;
+    memcpy(slot->sprites, sprites, sizeof(slot->sprites));
+}
+
+static void runWorker(ScreenCache* cache) {
+    AutotileSprite sprites[SCREEN_CACHE_SPRITES];
+
+    std::unique_lock<std::mutex> lock(cache->mutex);
+    for (;;) {
+        cache->condition.wait(lock, [cache] { return cache->isStopping || !cache->requests.empty(); });
+        if (cache->isStopping) return;
+
+        const int screenIndex = cache->requests.front();
+        cache->requests.pop_front();
+        if (findSlot(cache, screenIndex) != -1) continue;
+        const uint64_t generation = cache->generation;
+
+        // Load without holding the lock, so the game doesn't wait for us
+        lock.unlock();
+        bool isLoaded = false;
+        {
+            TRACE_SCOPE("screenCache prefetch");
+            std::lock_guard<std::mutex> worldLock(cache->worldMutex);
+            if (screenIndex >= 0 && screenIndex < cache->world->numScreens) {
+                autotileScreen(cache->world, screenIndex, sprites);
+                isLoaded = true;
+            }
+        }
+        lock.lock();
+
+        if (isLoaded && generation == cache->generation && findSlot(cache, screenIndex) == -1) {
+            installScreen(cache, screenIndex, sprites);
+            cache->stats.numPrefetched++;
+        }
+    }
+}
+
+ScreenCache* screenCacheCreate(const World* world, int capacity) {
+    ScreenCache* cache = new ScreenCache();
+    cache->world = world;
+    cache->slots.resize(capacity > 1 ? capacity : 1);
+    for (ScreenCacheSlot& slot : cache->slots) slot.screenIndex = -1;
+    cache->useCounter = 0;
+    cache->generation = 0;
+    cache->pinnedScreen = -1;
+    cache->isStopping = false;
+    cache->stats = {};
+    cache->thread = std::thread(runWorker, cache);
+    return cache;
+}
+
+void screenCacheDestroy(ScreenCache* cache) {
+    if (!cache) return;
+
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->isStopping = true;
+    }
+    cache->condition.notify_one();
+    cache->thread.join();
+    delete cache;
+}
+
+bool screenCacheTryGetSprites(ScreenCache* cache, int screenIndex, AutotileSprite* outSprites) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    const int slotIndex = findSlot(cache, screenIndex);
+    if (slotIndex == -1) return false;
+
+    ScreenCacheSlot* slot = &cache->slots[slotIndex];
+    slot->lastUsed = ++cache->useCounter;
+    memcpy(outSprites, slot->sprites, sizeof(slot->sprites));
+    return true;
+}
+
+bool screenCacheGetSprites(ScreenCache* cache, int screenIndex, AutotileSprite* outSprites) {
+    // Only the owner changes the world, so it can read it without the world lock
+    if (screenIndex < 0 || screenIndex >= cache->world->numScreens) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->pinnedScreen = screenIndex;
+    }
+    if (screenCacheTryGetSprites(cache, screenIndex, outSprites)) return true;
+
+    autotileScreen(cache->world, screenIndex, outSprites);
+
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (findSlot(cache, screenIndex) == -1) installScreen(cache, screenIndex, outSprites);
+    cache->stats.numMisses++;
+    return true;
+}
+
+void screenCachePrefetch(ScreenCache* cache, int screenIndex) {
+    if (screenIndex < 0 || screenIndex >= cache->world->numScreens) return;
+
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (findSlot(cache, screenIndex) != -1) return;
+        for (int request : cache->requests) {
+            if (request == screenIndex) return;
+        }
+        cache->requests.push_back(screenIndex);
+    }
+    cache->condition.notify_one();
+}
+
+void screenCachePause(ScreenCache* cache) {
+    cache->worldMutex.lock();
+}
+
+void screenCacheResume(ScreenCache* cache) {
+    cache->worldMutex.unlock();
+}
+
+void screenCacheInvalidate(ScreenCache* cache, int screenIndex) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    const int slotIndex = findSlot(cache, screenIndex);
+    if (slotIndex != -1) {
+        cache->slots[slotIndex].screenIndex = -1;
+        cache->stats.numResident--;
+    }
+    cache->generation++;
+}
+
+void screenCacheInvalidateAll(ScreenCache* cache) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    for (ScreenCacheSlot& slot : cache->slots) slot.screenIndex = -1;
+    cache->requests.clear();
+    cache->stats.numResident = 0;
+    cache->generation++;
+}
+
+ScreenCacheStats screenCacheGetStats(ScreenCache* cache) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    return cache->stats;
+}
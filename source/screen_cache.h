@@ -0,0 +1,49 @@
+// Screen streaming
+// ----------------
+// Big levels have thousands of screens, so the per-screen data derived from the tiles (autotile sprites)
+// is only kept for a bounded number of recently used screens (LRU), instead of for the whole level.
+// While the player is on a screen, the screens above and below are prefetched on a worker thread,
+// so crossing a screen boundary finds them ready and doesn't cause a hitch.
+// The worker reading the tiles also pages in mapped level files ahead of time.
+//
+// The cache reads the world from the worker thread, so changes to the world have to happen
+// between `screenCachePause` and `screenCacheResume`.
+#pragma once
+
+#include "sim.h"
+#include "autotile.h"
+
+// Number of resident screens
+#define SCREEN_CACHE_CAPACITY 16
+#define SCREEN_CACHE_SPRITES (TILEMAP_SIZE_X * TILEMAP_SIZE_Y)
+
+struct ScreenCache;
+
+struct ScreenCacheStats {
+    int numResident;
+    // Screens which weren't resident when they were needed, so they were loaded on the calling thread
+    int numMisses;
+    int numPrefetched;
+    int numEvicted;
+};
+
+// `world` has to outlive the cache, it's read from the worker thread.
+ScreenCache* screenCacheCreate(const World* world, int capacity);
+void screenCacheDestroy(ScreenCache* cache);
+
+// Copy the sprites of a screen (`SCREEN_CACHE_SPRITES`, row by row) to `outSprites`.
+// Loads the screen right away if it isn't resident. Returns false if the screen is outside of the world.
+bool screenCacheGetSprites(ScreenCache* cache, int screenIndex, AutotileSprite* outSprites);
+// Like `screenCacheGetSprites`, but only if the screen is resident already (never loads anything).
+bool screenCacheTryGetSprites(ScreenCache* cache, int screenIndex, AutotileSprite* outSprites);
+// Load the screen on the worker thread, if it isn't resident.
+void screenCachePrefetch(ScreenCache* cache, int screenIndex);
+
+// Wait until the worker isn't reading the world and keep it from reading it until `screenCacheResume`.
+void screenCachePause(ScreenCache* cache);
+void screenCacheResume(ScreenCache* cache);
+// Forget a screen (or all of them), e.g. after the level was edited. Call it while paused.
+void screenCacheInvalidate(ScreenCache* cache, int screenIndex);
+void screenCacheInvalidateAll(ScreenCache* cache);
+
+ScreenCacheStats screenCacheGetStats(ScreenCache* cache);
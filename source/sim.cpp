@@ -0,0 +1,548 @@
+#include "sim.h"
+#include "tile_grid.h"
+#include "profiler.h"
+#include <stdlib.h> // malloc, free
+#include <string.h> // memcmp
+
+// List of tilemaps for each screen in the level.
+// Note: starts at the top, the last one is the starting screen, so it looks continuous
+const Tilemap screenTilemaps[] = {
+    {
+        "################",
+        "#              #",
+        "# #### #### #  #",
+        "# #    #    #  #",
+        "# # ## # ## #  #",
+        "# #  # #  #    #",
+        "# #### #### #  #",
+        "#              #",
+        "#              #",
+        "#              #",
+        "#              #",
+        "#########      #",
+    },
+    {
+        "#########      #",
+        "#########    ###",
+        "########      ##",
+        "########      ##",
+        "##########     #",
+        "##########     #",
+        "########      ##",
+        "########      ##",
+        "##########    ##",
+        "######        ##",
+        "###           ##",
+        "###         ####",
+    },
+    {
+        "###         ####",
+        "###    ##   ####",
+        "###         ####",
+        "###          ###",
+        "#####        ###",
+        "###          ###",
+        "#            ###",
+        "##        ######",
+        "##         #####",
+        "##         #####",
+        "######     #####",
+        "#####      #####",
+    },
+    {
+        "#####      #####",
+        "###      #######",
+        "##        ######",
+        "##          ####",
+        "######      ####",
+        "######       ###",
+        "######   #   ###",
+        "#####    ##  ###",
+        "#####        ###",
+        "##           ###",
+        "##        ######",
+        "##    ##########",
+    },
+    // Starting screen:
+    {
+        "##    ##########",
+        "##            ##",
+        "####          ##",
+        "########       #",
+        "#####          #",
+        "##             #",
+        "##       #######",
+        "#        #######",
+        "#         ######",
+        "#####     ######",
+        "#####     ######",
+        "################",
+    },
+};
+
+const int screenTilemapsCount = arrayNumItems(screenTilemaps);
+
+// Built at compile time, so the table is ready before any other static initialization runs.
+static constexpr TileMaterialTable makeTileMaterials() {
+    TileMaterialTable table = {};
+
+    // Unknown bytes are solid, like they always were
+    const TileMaterial solid = { true, TILE_FRICTION_INSTANT, BOUNCE_FACTOR_X, 1.0f, { 0.0f, 0.0f }, { 255, 255, 255, 255 } };
+    const TileMaterial empty = { false, TILE_FRICTION_INSTANT, BOUNCE_FACTOR_X, 1.0f, { 0.0f, 0.0f }, { 0, 0, 0, 0 } };
+    for (int i = 0; i < 256; i++) table.materials[i] = solid;
+    table.materials[TILE_EMPTY] = empty;
+    table.materials[TILE_ZERO] = empty;
+
+    table.materials[TILE_ICE] = { true, 6.0f, BOUNCE_FACTOR_X, 1.0f, { 0.0f, 0.0f }, { 170, 220, 255, 255 } };
+    table.materials[TILE_SAND] = { true, TILE_FRICTION_INSTANT, 0.0f, 0.75f, { 0.0f, 0.0f }, { 230, 200, 130, 255 } };
+    table.materials[TILE_WIND_LEFT] = { false, TILE_FRICTION_INSTANT, BOUNCE_FACTOR_X, 1.0f, { -8.0f, 0.0f }, { 255, 255, 255, 24 } };
+    table.materials[TILE_WIND_RIGHT] = { false, TILE_FRICTION_INSTANT, BOUNCE_FACTOR_X, 1.0f, { 8.0f, 0.0f }, { 255, 255, 255, 24 } };
+    table.materials[TILE_WIND_UP] = { false, TILE_FRICTION_INSTANT, BOUNCE_FACTOR_X, 1.0f, { 0.0f, -20.0f }, { 255, 255, 255, 24 } };
+    return table;
+}
+
+const TileMaterialTable tileMaterials = makeTileMaterials();
+
+void worldInit(World* world, const Tilemap* screens, int numScreens) {
+    *world = {};
+    world->tiles = &screens[0][0][0];
+    world->rowStride = TILEMAP_SIZE_X + 1;
+    world->numScreens = numScreens;
+    world->numRows = numScreens * TILEMAP_SIZE_Y;
+    world->topY = -(float)((numScreens - 1) * TILEMAP_SIZE_Y);
+
+    // Precompute the collision mask
+    world->ownedMaskRows = (uint16_t*)malloc(sizeof(uint16_t) * (world->numRows > 0 ? world->numRows : 1));
+    for (int i = 0; i < numScreens; i++) {
+        tileGridGetCollisionRows(worldGetScreenGrid(world, i), &world->ownedMaskRows[i * TILEMAP_SIZE_Y]);
+    }
+    world->mask.rows = world->ownedMaskRows;
+    world->mask.numRows = world->numRows;
+    world->mask.tiles = world->tiles;
+    world->mask.rowStride = world->rowStride;
+}
+
+void worldInitBuiltin(World* world) {
+    worldInit(world, screenTilemaps, screenTilemapsCount);
+}
+
+void worldFree(World* world) {
+    free(world->ownedMaskRows);
+    *world = {};
+}
+
+Tile worldGetTile(const World* world, int x, int y) {
+    if (x < 0 || x >= TILEMAP_SIZE_X) return OUTSIDE_TILE_HORIZONTAL;
+    if (y < 0 || y >= world->numRows) return OUTSIDE_TILE_VERTICAL;
+    return (Tile)world->tiles[(size_t)y * world->rowStride + x];
+}
+
+Tile worldGetTileFullOutside(const World* world, int x, int y) {
+    if (x < 0 || x >= TILEMAP_SIZE_X) return TILE_FULL;
+    if (y < 0 || y >= world->numRows) return TILE_FULL;
+    return (Tile)world->tiles[(size_t)y * world->rowStride + x];
+}
+
+bool worldIsTileFull(const World* world, int x, int y) {
+    return isTileFull(worldGetTile(world, x, y));
+}
+
+int worldGetRowAtHeight(const World* world, float height) {
+    return (int)floorf(height - world->topY);
+}
+
+bool worldIsScreenEqual(const World* a, const World* b, int screenIndex) {
+    if (screenIndex < 0 || screenIndex >= a->numScreens || screenIndex >= b->numScreens) return false;
+
+    const int screenRow = screenIndex * TILEMAP_SIZE_Y;
+    for (int y = screenRow; y < screenRow + TILEMAP_SIZE_Y; y++) {
+        const uint8_t* rowA = &a->tiles[(size_t)y * a->rowStride];
+        const uint8_t* rowB = &b->tiles[(size_t)y * b->rowStride];
+        if (memcmp(rowA, rowB, TILEMAP_SIZE_X) != 0) return false;
+    }
+    return true;
+}
+
+// Get the screen index, where start = 0 and increases when you move up (-Y)
+int getScreenHeightIndex(float height) {
+    return floorf(-height / TILEMAP_SIZE_Y);
+}
+
+// Get start and end coordinates of the boxes a bounding box on the tilemap grid
+void getTilesOverlappedByBox(int* outStartX, int* outStartY, int* outEndX, int* outEndY, Vector2 center, const Vector2 size) {
+    *outStartX = int(floorf(center.x - size.x));
+    *outStartY = int(floorf(center.y - size.y));
+    *outEndX = int(floorf(center.x + size.x));
+    *outEndY = int(floorf(center.y + size.y));
+}
+
+// This function takes a box and a tilemap, and tries to make sure the box
+// doesn't intersect with the tilemap.
+// 
+// The method:
+// First, we iterate all of the tiles that *could* be colliding with the box (based on the bounding volume).
+// Next, we calculate the distance between near surfaces on each axis.
+// Then we find an axis to 'clip' the position and velocity against.
+// 
+// Note: the `size` is half-extent: it's the vector from the center of the box to it's corner.
+//  It's half the actual width and height of the box.
+void resolveBoxCollisionWithTilemap(const CollisionMask* mask, float tilemapHeight, Vector2* center, Vector2* velocity, const Vector2 size) {
+    // Add the offset to center (simply transform into tilemap local-space)
+    center->y -= tilemapHeight;
+
+    int startX = 0;
+    int startY = 0;
+    int endX = 0;
+    int endY = 0;
+    // Get neighbor tile ranges
+    getTilesOverlappedByBox(&startX, &startY, &endX, &endY, *center, size);
+
+    // Quick exit when none of the close tiles are full
+    const uint32_t spanBits = collisionMaskSpanBits(startX, endX);
+    bool isAnyFull = false;
+    for (int y = startY; y <= endY; y++) {
+        isAnyFull |= (collisionMaskRowBits(mask, y) & spanBits) != 0;
+    }
+    if (!isAnyFull) {
+        center->y += tilemapHeight;
+        return;
+    }
+
+    // Iterate over close tiles
+    for (int x = startX; x <= endX; x++) {
+        for (int y = startY; y <= endY; y++) {
+            // Skip if non-empty
+            if (!collisionMaskIsFull(mask, x, y)) continue;
+
+            // Center of the tile box
+            const Vector2 boxPos = { 0.5f + (float)x, 0.5f + (float)y };
+            const Vector2 sizeSum = { size.x + 0.5f, size.y + 0.5 };
+            const Vector2 surfDist = {
+                fabsf(center->x - boxPos.x) - sizeSum.x,
+                fabsf(center->y - boxPos.y) - sizeSum.y,
+            };
+
+            // The two boxes aren't colliding, because
+            // the distance between the surfaces is larger than
+            // zero on one of the axes.
+            if (surfDist.x > 0 || surfDist.y > 0) continue;
+
+            // Now check the closer neighboring tiles on each axis.
+            // If the tile is empty (and current tile is full), that means
+            // there exists an edge between the two tiles.
+            // Our box should collide against such an edge.
+            // On the other hand, if there is no edge, the box is inside the tiles
+            // and collision cannot be resolved.
+            const bool isXEmpty = !collisionMaskIsFull(mask, x + (center->x > boxPos.x ? 1 : -1), y);
+            // Warning: positive Y is down in this setup!
+            const bool isYEmpty = !collisionMaskIsFull(mask, x, y + (center->y > boxPos.y ? 1 : -1));
+
+            // If both neighbors are empty, there aren't any edges to collide against.
+            if (!isXEmpty && !isYEmpty) continue;
+
+            // Clip axis is the axis of an edge which we don't want our box to intersect.
+            bool isClipAxisX = isXEmpty;
+            // In case there are two edges, just get the axis which has the least amount of penetration.
+            if (isXEmpty && isYEmpty) {
+                isClipAxisX = surfDist.x > surfDist.y;
+            }
+
+            // Clip the velocity (or bounce) based on the axis
+            if (isClipAxisX) {
+                const float bounceX = collisionMaskGetMaterial(mask, x, y)->bounceX;
+                if (center->x > boxPos.x) {
+                    // Clamp the position exactly to the surface
+                    center->x = boxPos.x + sizeSum.x;
+                    if (velocity->x < 0.0) {
+                        velocity->x = -velocity->x * bounceX;
+                    }
+                }
+                else {
+                    center->x = boxPos.x - sizeSum.x;
+                    if (velocity->x > 0.0) {
+                        velocity->x = -velocity->x * bounceX;
+                    }
+                }
+            }
+            else {
+                if (center->y > boxPos.y) {
+                    center->y = boxPos.y + sizeSum.y;
+                    velocity->y = fmaxf(velocity->y, 0.0f);
+                }
+                else {
+                    center->y = boxPos.y - sizeSum.y;
+                    velocity->y = fminf(velocity->y, 0.0f);
+                }
+            }
+        } // y
+    } // x
+
+    // Remove the local-space offset
+    center->y += tilemapHeight;
+}
+
+// Checks whether the box is intersecting (or touching) any tile in the tilemap.
+// param `mask`: collision mask of the tilemap to check
+// param `tilemapHeight`: offset of the tilemap along the Y axis
+// param `center`: coordinate of the center of the box
+// param `size`: half-extent of the box - half the box sides
+bool isBoxCollidingWithTilemap(const CollisionMask* mask, float tilemapHeight, Vector2 center, const Vector2 size) {
+    center.y -= tilemapHeight;
+
+    int startX = 0;
+    int startY = 0;
+    int endX = 0;
+    int endY = 0;
+    // Get neighbor tile ranges
+    getTilesOverlappedByBox(&startX, &startY, &endX, &endY, center, size);
+
+    // Every tile in the range overlaps (or touches) the box,
+    // so we only need to know if any of them is full.
+    const uint32_t spanBits = collisionMaskSpanBits(startX, endX);
+    for (int y = startY; y <= endY; y++) {
+        if (collisionMaskRowBits(mask, y) & spanBits) return true;
+    }
+
+    return false;
+}
+
+// Swept box vs tilemap query (continuous collision detection).
+// Finds the first time the box touches a full tile while moving by `motion`,
+// so fast boxes can't tunnel through thin walls, no matter the step size.
+//
+// The method:
+// This is a DDA (grid traversal) of the box's leading edges. On each axis we track the next
+// grid line the leading edge will cross and the time when that happens. We always step the
+// axis which crosses first, and check the new row/column of tiles the box enters, over the
+// range it covers on the other axis at that time.
+//
+// Like `resolveBoxCollisionWithTilemap`, faces between two full tiles are ignored, because
+// the box can't hit them from the outside.
+bool sweepBoxAgainstTilemap(const CollisionMask* mask, float tilemapHeight, Vector2 center, const Vector2 size, const Vector2 motion, SweepHit* outHit) {
+    center.y -= tilemapHeight;
+
+    const float lo[2] = { center.x - size.x, center.y - size.y };
+    const float hi[2] = { center.x + size.x, center.y + size.y };
+    const float move[2] = { motion.x, motion.y };
+
+    int step[2] = {};
+    int next[2] = {}; // Index of the next row/column of tiles the box enters
+    float tMax[2] = {}; // Time when the leading edge reaches it
+    float tDelta[2] = {}; // Time to cross one tile
+
+    for (int axis = 0; axis < 2; axis++) {
+        if (move[axis] > 0.0f) {
+            step[axis] = 1;
+            next[axis] = (int)floorf(hi[axis] - SWEEP_EPSILON) + 1;
+            tMax[axis] = ((float)next[axis] - hi[axis]) / move[axis];
+            tDelta[axis] = 1.0f / move[axis];
+        }
+        else if (move[axis] < 0.0f) {
+            step[axis] = -1;
+            next[axis] = (int)floorf(lo[axis] + SWEEP_EPSILON) - 1;
+            tMax[axis] = ((float)(next[axis] + 1) - lo[axis]) / move[axis];
+            tDelta[axis] = -1.0f / move[axis];
+        }
+        else {
+            tMax[axis] = INFINITY;
+        }
+        tMax[axis] = fmaxf(tMax[axis], 0.0f);
+    }
+
+    for (;;) {
+        const int axis = tMax[0] <= tMax[1] ? 0 : 1;
+        const int other = 1 - axis;
+        const float time = tMax[axis];
+        if (time > 1.0f) return false;
+
+        // Range of tiles the box covers on the other axis at this time.
+        // Just touching a tile (sliding along it) doesn't count.
+        const int start = (int)floorf(lo[other] + move[other] * time + SWEEP_EPSILON);
+        const int end = (int)floorf(hi[other] + move[other] * time - SWEEP_EPSILON);
+
+        for (int i = start; i <= end; i++) {
+            const int x = axis == 0 ? next[0] : i;
+            const int y = axis == 0 ? i : next[1];
+            if (!collisionMaskIsFull(mask, x, y)) continue;
+
+            // Skip the face if the tile we're coming from is full as well.
+            const int fromX = axis == 0 ? x - step[0] : x;
+            const int fromY = axis == 0 ? y : y - step[1];
+            if (collisionMaskIsFull(mask, fromX, fromY)) continue;
+
+            outHit->time = time;
+            outHit->normal = axis == 0 ? Vector2{ (float)-step[0], 0.0f } : Vector2{ 0.0f, (float)-step[1] };
+            outHit->tileX = x;
+            outHit->tileY = y;
+            return true;
+        }
+
+        next[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+    }
+}
+
+// Moves the box by `velocity * delta`, stopping at tile surfaces found by `sweepBoxAgainstTilemap`.
+// The velocity is clipped (or bounced, on the X axis) the same way as in `resolveBoxCollisionWithTilemap`,
+// and the rest of the motion continues along the surface.
+void moveBoxWithTilemap(const CollisionMask* mask, float tilemapHeight, Vector2* center, Vector2* velocity, const Vector2 size, float delta) {
+    Vector2 motion = Vector2Scale(*velocity, delta);
+
+    // Every hit removes the motion on one axis, so there can't be more than two.
+    for (int i = 0; i < 2; i++) {
+        SweepHit hit = {};
+        if (!sweepBoxAgainstTilemap(mask, tilemapHeight, *center, size, motion, &hit)) break;
+
+        *center = Vector2Add(*center, Vector2Scale(motion, hit.time));
+        motion = Vector2Scale(motion, 1.0f - hit.time);
+
+        if (hit.normal.x != 0.0f) {
+            if (velocity->x * hit.normal.x < 0.0f) {
+                velocity->x = -velocity->x * collisionMaskGetMaterial(mask, hit.tileX, hit.tileY)->bounceX;
+            }
+            motion.x = 0.0f;
+        }
+        else {
+            if (velocity->y * hit.normal.y < 0.0f) {
+                velocity->y = 0.0f;
+            }
+            motion.y = 0.0f;
+        }
+    }
+
+    *center = Vector2Add(*center, motion);
+}
+
+// Move `value` towards `target`, by at most `maxStep`.
+// Lands exactly on the target when it's close enough, so instant friction doesn't leave rounding errors behind.
+static float moveTowards(float value, float target, float maxStep) {
+    const float diff = target - value;
+    return fabsf(diff) <= maxStep ? target : value + copysignf(maxStep, diff);
+}
+
+// Material the player stands on: the tile below their center,
+// or the one next to it if the center is over empty space (standing on an edge).
+static const TileMaterial* getGroundMaterial(const CollisionMask* mask, float tilemapHeight, Vector2 position) {
+    const int groundY = (int)floorf(position.y + PLAYER_SIZE.y + 0.05f - tilemapHeight);
+    const int centerX = (int)floorf(position.x);
+    const int edgeX = position.x - (float)centerX < 0.5f ? centerX - 1 : centerX + 1;
+    const TileMaterial* center = collisionMaskGetMaterial(mask, centerX, groundY);
+    return center->isSolid ? center : collisionMaskGetMaterial(mask, edgeX, groundY);
+}
+
+// Apply input and update player movement
+void updatePlayer(Player* player, const CollisionMask* mask, float tilemapHeight, Input input, Input prevInput, float delta) {
+    const Input pressed = (Input)(input & ~prevInput);
+    const Input released = (Input)(prevInput & ~input);
+
+    player->velocity.y += PLAYER_GRAVITY * delta;
+    const bool isOnGround = isBoxCollidingWithTilemap(
+        mask,
+        tilemapHeight,
+        { player->position.x, player->position.y + PLAYER_SIZE.y },
+        { 0.1, 0.05 });
+
+    player->isOnGround = isOnGround;
+
+    // Wind of the tile the player's center is in (none outside of wind zones)
+    const TileMaterial* air = collisionMaskGetMaterial(mask,
+        (int)floorf(player->position.x), (int)floorf(player->position.y - tilemapHeight));
+    player->velocity = Vector2Add(player->velocity, Vector2Scale(air->wind, delta));
+
+    if (isOnGround) {
+        const TileMaterial* ground = getGroundMaterial(mask, tilemapHeight, player->position);
+        const float slideVelocityX = player->velocity.x;
+        bool isJumping = false;
+
+        player->velocity.x = 0;
+
+        if (released & INPUT_JUMP) {
+            // Calculate strength based on how long the user held down the jump key.
+            // The numbers are kind of random, you play with it yourself.
+            const float jumpStrength = Clamp(player->jumpHoldTime * 2.6f, 1.1f, 2.0f) / 2.0f;
+
+            // If the player doesn't press anything, the direction is up.
+            Vector2 dir = { 0.0f, -1.0f };
+            const float xMoveStrength = 0.75f - (jumpStrength * 0.5f);
+            if (input & INPUT_RIGHT) dir.x += xMoveStrength;
+            if (input & INPUT_LEFT) dir.x -= xMoveStrength;
+            // Make sure the vector is unit vector (length = 1.0).
+            dir = Vector2Normalize(dir);
+
+            // Multiply the vector length by the strength factor.
+            dir = Vector2Scale(dir, jumpStrength * PLAYER_JUMP_STRENGTH * ground->jumpFactor);
+            // Now apply the jump vector to the actual velocity
+            player->velocity = dir;
+            isJumping = true;
+        }
+
+        if (input & INPUT_JUMP) {
+            player->jumpHoldTime += delta;
+        }
+        else {
+            player->jumpHoldTime = 0.0f;
+            if (input & INPUT_RIGHT) {
+                player->velocity.x += PLAYER_WALK_SPEED;
+                player->isFacingRight = true;
+            }
+            if (input & INPUT_LEFT) {
+                player->velocity.x -= PLAYER_WALK_SPEED;
+                player->isFacingRight = false;
+            }
+
+            if (pressed & (INPUT_LEFT | INPUT_RIGHT)) {
+                player->animTime = 0;
+            }
+        }
+
+        // The velocity we got so far is where the player wants to go,
+        // the ground's friction decides how fast they get there (right away on most tiles)
+        if (!isJumping) {
+            player->velocity.x = moveTowards(slideVelocityX, player->velocity.x, ground->friction * delta);
+        }
+    }
+    else {
+        player->jumpHoldTime = 0.0f;
+    }
+
+    // Clamp velocity
+    float vel = Vector2Length(player->velocity);
+    if (vel > PLAYER_MAX_SPEED) vel = PLAYER_MAX_SPEED;
+    player->velocity = Vector2Scale(Vector2Normalize(player->velocity), vel);
+}
+
+int getPlayerSprite(const Player* player) {
+    // Pick an sprite/animation based on player state
+    if (!player->isOnGround) return player->velocity.y > 0 ? 5 : 6;
+    if (player->jumpHoldTime > 0.001) return 4;
+    if (fabsf(player->velocity.x) > 0.01) return 1 + ((int)floorf(player->animTime * 6.0f)) % 2;
+    return 0;
+}
+
+void simInit(SimState* state, const World* world) {
+    *state = {};
+    state->world = world;
+    state->player.position = { (float)TILEMAP_SIZE_X / 2, (float)TILEMAP_SIZE_Y / 2 };
+}
+
+void simStep(SimState* state, Input input, float delta) {
+    TRACE_SCOPE("simStep");
+    // The whole level is one grid, so we don't care which screen the player is on.
+    const CollisionMask* mask = &state->world->mask;
+    const float worldTopY = state->world->topY;
+
+    {
+        PROFILE_SCOPE(PROFILE_UPDATE_PLAYER);
+        updatePlayer(&state->player, mask, worldTopY, input, state->prevInput, delta);
+    }
+    {
+        PROFILE_SCOPE(PROFILE_COLLISION);
+        moveBoxWithTilemap(mask, worldTopY, &state->player.position, &state->player.velocity, PLAYER_SIZE, delta);
+        // The sweep never ends up inside a tile on it's own, but this still pushes the box out
+        // if it started overlapping (e.g. after being teleported).
+        resolveBoxCollisionWithTilemap(mask, worldTopY, &state->player.position, &state->player.velocity, PLAYER_SIZE);
+    }
+
+    state->prevInput = input;
+    state->tick++;
+}
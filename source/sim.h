@@ -0,0 +1,248 @@
+// Headless simulation core
+// ------------------------
+// Everything needed to advance the game world by one tick: tilemaps, collision and player movement.
+// This doesn't depend on the raylib window, GL context or keyboard state, so it can run
+// on machines without a GPU (level validation, physics regression tests, batch runs).
+//
+// Note: when used together with raylib, include "raylib.h" *before* this header,
+// because raymath only declares `Vector2` if raylib didn't already.
+#pragma once
+
+#include "raymath.h" // Vector math (header-only, doesn't need the raylib library)
+#include <stdint.h>
+#include <stddef.h> // size_t
+
+#define TILEMAP_SIZE_X 16
+#define TILEMAP_SIZE_Y 12
+// What happens when we get out of grid horizontally
+#define OUTSIDE_TILE_HORIZONTAL TILE_FULL
+// What happens when we get out of grid vertically
+#define OUTSIDE_TILE_VERTICAL TILE_EMPTY
+// How much should the box in `resolveBoxCollisionWithTilemap` bounce of off walls (of the default material).
+// Mainly player uses this to bounce.
+#define BOUNCE_FACTOR_X 0.45f
+// Friction of materials which stop the player right away (the default), in units (tiles) per second squared
+#define TILE_FRICTION_INSTANT 1e9f
+// Tolerance used by `sweepBoxAgainstTilemap`, so boxes resting exactly on a surface
+// don't count as overlapping the tiles they touch.
+#define SWEEP_EPSILON 0.0001f
+
+// The simulation runs at a fixed rate, independent of the rendering frame rate.
+// This makes jump arcs and jump charging the same on every machine.
+#define SIM_TICK_RATE 120
+#define SIM_TICK_DELTA (1.0f / SIM_TICK_RATE)
+
+// Number of items in a static (fixed-size) array
+#define arrayNumItems(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+// Half-size of the player's box collider.
+#define PLAYER_SIZE Vector2{0.3f, 0.4f}
+// Gravity in units (tiles) per second
+#define PLAYER_GRAVITY 30.0f
+// How fast player walks, in units (tiles) per second.
+// Ground velocity is reset every tick, so this is a speed, not an acceleration.
+// (Matches the old `200 * delta` at 60 FPS.)
+#define PLAYER_WALK_SPEED 3.33f
+#define PLAYER_GROUND_FRICTION_X 70.0f
+#define PLAYER_JUMP_STRENGTH 15.0f
+// Player's velocity is clamped to this length every tick, in units (tiles) per second.
+#define PLAYER_MAX_SPEED 25.0f
+
+struct Player {
+    Vector2 position;
+    Vector2 velocity;
+    float jumpHoldTime;
+    float animTime;
+    bool isOnGround;
+    bool isFacingRight;
+};
+
+enum Tile {
+    TILE_EMPTY = ' ',
+    TILE_ZERO = '\0',
+    TILE_FULL = '#',
+    // Slippery ground, the player keeps sliding after walking or landing
+    TILE_ICE = '=',
+    // Soft ground, jumps from it are weaker and walls made of it don't bounce
+    TILE_SAND = ':',
+    // Empty space with wind blowing through it, pushes the player around
+    TILE_WIND_LEFT = '<',
+    TILE_WIND_RIGHT = '>',
+    TILE_WIND_UP = '^',
+};
+
+// Physical properties of a tile.
+// Every raw tile byte has its own material in `tileMaterials`, so the physics get everything about a tile
+// with a single indexed load, and adding more kinds of tiles doesn't add any branches.
+// Bytes which aren't in `enum Tile` are plain solid tiles, like TILE_FULL.
+struct TileMaterial {
+    // Does the tile block movement (is it set in the `CollisionMask`)?
+    bool isSolid;
+    // How fast the player's horizontal velocity gets to the walking velocity while standing on the tile,
+    // in units (tiles) per second squared
+    float friction;
+    // Horizontal velocity is multiplied by -bounceX when hitting a side of the tile
+    float bounceX;
+    // Jumps from the tile are multiplied by this
+    float jumpFactor;
+    // Acceleration of the player while their center is inside of the tile, in units (tiles) per second squared
+    Vector2 wind;
+    // Color the tile is drawn with (RGBA), non-solid tiles are only drawn if it isn't transparent
+    uint8_t tint[4];
+};
+
+struct TileMaterialTable {
+    TileMaterial materials[256];
+};
+
+extern const TileMaterialTable tileMaterials;
+
+inline const TileMaterial* getTileMaterial(uint8_t tile) {
+    return &tileMaterials.materials[tile];
+}
+
+// Does the tile block movement?
+inline bool isTileFull(uint8_t tile) {
+    return tileMaterials.materials[tile].isSolid;
+}
+
+// Tilemap is a grid of tiles (`Tile` enums, stored as unsigned bytes).
+// The '+ 1' is there for string null-termination, because
+// we're defining the tilemaps with strings.
+template <int SizeX, int SizeY>
+using TilemapOf = uint8_t[SizeY][SizeX + 1];
+// Tilemap of a single screen of the game
+typedef TilemapOf<TILEMAP_SIZE_X, TILEMAP_SIZE_Y> Tilemap;
+
+// Precomputed solidity of the level, one bit per tile (bit X of row Y is set if the tile is full).
+// Collision queries only ever look at these, the ASCII tiles are for drawing, editing and looking up materials.
+struct CollisionMask {
+    const uint16_t* rows;
+    int numRows;
+    // ASCII tiles the mask was made from (`World::tiles`), `rowStride` bytes apart
+    const uint8_t* tiles;
+    int rowStride;
+};
+
+static_assert(TILEMAP_SIZE_X <= 16, "CollisionMask rows can't fit the tilemap width");
+
+// The whole level as one tall, contiguous grid of tiles.
+// Screens are stacked on top of each other, row 0 is the top row of the highest screen
+// and the last screen is the starting one, which spans world-space Y from 0 to TILEMAP_SIZE_Y.
+struct World {
+    // ASCII tiles (`Tile` enums), `numRows` rows of TILEMAP_SIZE_X tiles, `rowStride` bytes apart.
+    const uint8_t* tiles;
+    int rowStride;
+    int numRows;
+    int numScreens;
+    // World-space Y coordinate of row 0
+    float topY;
+    CollisionMask mask;
+    // Mask rows allocated by `worldInit`, NULL if they live elsewhere (e.g. in a mapped level file)
+    uint16_t* ownedMaskRows;
+};
+
+// List of tilemaps for each screen in the built-in level.
+// Note: starts at the top, the last one is the starting screen, so it looks continuous.
+extern const Tilemap screenTilemaps[];
+extern const int screenTilemapsCount;
+
+// Player input for a single tick, as a set of `InputBits`.
+// The simulation only sees these, never the keyboard directly.
+typedef uint8_t Input;
+
+enum InputBits {
+    INPUT_JUMP = 1 << 0,
+    INPUT_LEFT = 1 << 1,
+    INPUT_RIGHT = 1 << 2,
+};
+
+// Result of `sweepBoxAgainstTilemap`.
+struct SweepHit {
+    // Time of impact, as a fraction of the motion [0, 1].
+    float time;
+    // Normal of the tile face which was hit (points away from the tile).
+    Vector2 normal;
+    // Tile which was hit, in tilemap local-space
+    int tileX;
+    int tileY;
+};
+
+// Whole state of the simulated world.
+// Copying this struct is enough to snapshot the game.
+struct SimState {
+    // Level we're simulating in (not owned)
+    const World* world;
+    Player player;
+    // Input from the previous tick, used to detect presses and releases.
+    Input prevInput;
+    uint64_t tick;
+};
+
+// Make a world from screens stored one after another (top screen first).
+// The tiles are used in place, they have to outlive the world.
+void worldInit(World* world, const Tilemap* screens, int numScreens);
+// World made of the built-in `screenTilemaps`.
+void worldInitBuiltin(World* world);
+void worldFree(World* world);
+
+// Tile at column `x` and row `y` of the world grid (row 0 is the top of the level).
+Tile worldGetTile(const World* world, int x, int y);
+Tile worldGetTileFullOutside(const World* world, int x, int y);
+bool worldIsTileFull(const World* world, int x, int y);
+// World grid row at a world-space height.
+int worldGetRowAtHeight(const World* world, float height);
+// Do both worlds have the same tiles on the screen? Used to find out which screens were edited.
+bool worldIsScreenEqual(const World* a, const World* b, int screenIndex);
+
+// Row of a collision mask shifted left by one bit, with the tiles outside of the map filled in
+// according to OUTSIDE_TILE_HORIZONTAL and OUTSIDE_TILE_VERTICAL.
+// Bit 0 is x = -1, bit 1 is x = 0 and so on, all bits above the map are outside as well.
+inline uint32_t collisionMaskRowBits(const CollisionMask* mask, int y) {
+    const uint32_t insideBits = ((1u << TILEMAP_SIZE_X) - 1u) << 1;
+    const uint32_t outsideBits = OUTSIDE_TILE_HORIZONTAL == TILE_FULL ? ~insideBits : 0u;
+    if ((unsigned)y >= (unsigned)mask->numRows) return outsideBits | (OUTSIDE_TILE_VERTICAL == TILE_FULL ? insideBits : 0u);
+    return outsideBits | ((uint32_t)mask->rows[y] << 1);
+}
+
+// Bits of `collisionMaskRowBits` covering the tiles from `startX` to `endX` (inclusive).
+inline uint32_t collisionMaskSpanBits(int startX, int endX) {
+    // Everything further outside behaves the same as the first tile outside.
+    startX = startX < -1 ? -1 : (startX > TILEMAP_SIZE_X ? TILEMAP_SIZE_X : startX);
+    endX = endX < -1 ? -1 : (endX > TILEMAP_SIZE_X ? TILEMAP_SIZE_X : endX);
+    if (endX < startX) return 0;
+    return (uint32_t)(((2ull << (endX + 1)) - 1ull) & ~((1ull << (startX + 1)) - 1ull));
+}
+
+inline bool collisionMaskIsFull(const CollisionMask* mask, int x, int y) {
+    return (collisionMaskRowBits(mask, y) & collisionMaskSpanBits(x, x)) != 0;
+}
+
+// Material of the tile, tiles outside of the map are OUTSIDE_TILE_HORIZONTAL and OUTSIDE_TILE_VERTICAL
+// (the same way `collisionMaskRowBits` fills them in).
+inline const TileMaterial* collisionMaskGetMaterial(const CollisionMask* mask, int x, int y) {
+    uint8_t tile = OUTSIDE_TILE_HORIZONTAL;
+    if ((unsigned)x < (unsigned)TILEMAP_SIZE_X) {
+        tile = (unsigned)y < (unsigned)mask->numRows ? mask->tiles[(size_t)y * mask->rowStride + x] : (uint8_t)OUTSIDE_TILE_VERTICAL;
+    }
+    return getTileMaterial(tile);
+}
+
+// Get the screen index, where start = 0 and increases when you move up (-Y)
+int getScreenHeightIndex(float height);
+
+void getTilesOverlappedByBox(int* outStartX, int* outStartY, int* outEndX, int* outEndY, Vector2 center, const Vector2 size);
+void resolveBoxCollisionWithTilemap(const CollisionMask* mask, float tilemapHeight, Vector2* center, Vector2* velocity, const Vector2 size);
+bool isBoxCollidingWithTilemap(const CollisionMask* mask, float tilemapHeight, Vector2 center, const Vector2 size);
+bool sweepBoxAgainstTilemap(const CollisionMask* mask, float tilemapHeight, Vector2 center, const Vector2 size, const Vector2 motion, SweepHit* outHit);
+void moveBoxWithTilemap(const CollisionMask* mask, float tilemapHeight, Vector2* center, Vector2* velocity, const Vector2 size, float delta);
+
+// Apply input and update player movement
+void updatePlayer(Player* player, const CollisionMask* mask, float tilemapHeight, Input input, Input prevInput, float delta);
+// Sprite (column of the player sheet) for the player's state. `animTime` has to be advanced by the caller.
+int getPlayerSprite(const Player* player);
+
+// Put the player at the starting position on the starting screen of the `world`.
+void simInit(SimState* state, const World* world);
+// Advance the whole simulation by `delta` seconds.
+void simStep(SimState* state, Input input, float delta);
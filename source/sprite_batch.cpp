@@ -0,0 +1,79 @@
+#include "raylib.h"
+#include "sprite_batch.h"
+#include <stddef.h> // NULL
+
+void spriteBatchInit(SpriteBatch* batch, int capacity) {
+    *batch = {};
+    // One vertex buffer, every element is a quad
+    batch->batch = rlLoadRenderBatch(1, capacity);
+    batch->capacity = capacity;
+}
+
+void spriteBatchFree(SpriteBatch* batch) {
+    rlUnloadRenderBatch(batch->batch);
+    *batch = {};
+}
+
+static void beginDraw(SpriteBatch* batch) {
+    rlSetTexture(batch->texture.id);
+    rlBegin(RL_QUADS);
+}
+
+static void endDraw(SpriteBatch* batch) {
+    rlEnd();
+    if (batch->numPending > 0) batch->numDraws++;
+    batch->numPending = 0;
+}
+
+void spriteBatchBegin(SpriteBatch* batch, const Texture texture) {
+    // This flushes raylib's own batch, so the order of drawing is kept.
+    rlSetRenderBatchActive(&batch->batch);
+    batch->texture = texture;
+    beginDraw(batch);
+}
+
+void spriteBatchAdd(SpriteBatch* batch, const Rectangle source, const Vector2 position, bool isFlippedX, const Color tint) {
+    // The vertex buffer is full, submit it and continue with an empty one.
+    if (batch->numPending == batch->capacity) {
+        endDraw(batch);
+        rlDrawRenderBatchActive();
+        beginDraw(batch);
+    }
+
+    const float width = (float)batch->texture.width;
+    const float height = (float)batch->texture.height;
+    float u0 = source.x / width;
+    float u1 = (source.x + source.width) / width;
+    const float v0 = source.y / height;
+    const float v1 = (source.y + source.height) / height;
+    if (isFlippedX) {
+        const float u = u0;
+        u0 = u1;
+        u1 = u;
+    }
+
+    // Same vertex order as raylib's `DrawTexturePro`
+    rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+    rlTexCoord2f(u0, v0);
+    rlVertex2f(position.x, position.y);
+    rlTexCoord2f(u0, v1);
+    rlVertex2f(position.x, position.y + source.height);
+    rlTexCoord2f(u1, v1);
+    rlVertex2f(position.x + source.width, position.y + source.height);
+    rlTexCoord2f(u1, v0);
+    rlVertex2f(position.x + source.width, position.y);
+
+    batch->numPending++;
+    batch->numQuads++;
+}
+
+void spriteBatchEnd(SpriteBatch* batch) {
+    endDraw(batch);
+    // Draws our batch and makes the default one active again
+    rlSetRenderBatchActive(NULL);
+}
+
+void spriteBatchResetStats(SpriteBatch* batch) {
+    batch->numQuads = 0;
+    batch->numDraws = 0;
+}
@@ -0,0 +1,35 @@
+// Sprite batch
+// ------------
+// Draws many sprites from one texture with a single draw call.
+// The quads are written into our own pre-sized rlgl vertex buffer (`rlRenderBatch`),
+// so there are no per-sprite texture state checks, and the whole buffer is submitted at once.
+//
+// Note: include "raylib.h" before this header.
+#pragma once
+
+#include "rlgl.h" // Low-level render batches
+
+struct SpriteBatch {
+    rlRenderBatch batch;
+    // Maximum number of quads in a single draw
+    int capacity;
+    // Quads in the current draw, which weren't submitted yet
+    int numPending;
+    Texture texture;
+
+    // Stats, reset by `spriteBatchResetStats`
+    int numQuads;
+    int numDraws;
+};
+
+void spriteBatchInit(SpriteBatch* batch, int capacity);
+void spriteBatchFree(SpriteBatch* batch);
+
+// Start adding sprites from `texture`. Everything raylib had queued so far gets drawn first.
+void spriteBatchBegin(SpriteBatch* batch, const Texture texture);
+// Queue a sprite, `source` is a rectangle in the texture (in pixels), drawn 1:1 at `position`.
+void spriteBatchAdd(SpriteBatch* batch, const Rectangle source, const Vector2 position, bool isFlippedX, const Color tint);
+// Submit the queued sprites and switch back to raylib's default batch.
+void spriteBatchEnd(SpriteBatch* batch);
+
+void spriteBatchResetStats(SpriteBatch* batch);
@@ -0,0 +1,62 @@
+// Tile grids
+// ----------
+// A screen of tiles with its size as template parameters (`TileGrid<SizeX, SizeY>`), so the loops over it
+// have compile-time trip counts and get unrolled (and vectorized) for the size the game uses (`ScreenGrid`).
+// Screens stay TILEMAP_SIZE_X wide, because `CollisionMask` rows (also stored in level files) are 16 bits.
+//
+// Grids don't own anything, they point at tiles stored somewhere else (in a `World`, a `Tilemap`, a level file).
+#pragma once
+
+#include "sim.h"
+#include <stddef.h> // size_t
+
+// Row bits of a grid are 32 bits with a tile of the outside on both sides, see `autotileGetRowBits`
+#define TILE_GRID_MAX_SIZE_X 30
+
+template <int SizeX, int SizeY>
+struct TileGrid {
+    static_assert(SizeX > 0 && SizeX <= TILE_GRID_MAX_SIZE_X, "Collision rows can't fit the grid width");
+    static_assert(SizeY > 0, "Grid has to have rows");
+
+    // ASCII tiles (`Tile` enums), `SizeY` rows of `SizeX` tiles, `rowStride` bytes apart
+    const uint8_t* tiles;
+    int rowStride;
+    // Rows touching the grid from above and below (on the neighboring screens), NULL if they're outside of the level
+    const uint8_t* rowAbove;
+    const uint8_t* rowBelow;
+
+    static constexpr int getSizeX() { return SizeX; }
+    static constexpr int getSizeY() { return SizeY; }
+};
+
+// Grid of a single screen of the game
+typedef TileGrid<TILEMAP_SIZE_X, TILEMAP_SIZE_Y> ScreenGrid;
+
+inline ScreenGrid worldGetScreenGrid(const World* world, int screenIndex) {
+    const int screenRow = screenIndex * TILEMAP_SIZE_Y;
+    ScreenGrid grid = {};
+    grid.tiles = &world->tiles[(size_t)screenRow * world->rowStride];
+    grid.rowStride = world->rowStride;
+    grid.rowAbove = screenRow > 0 ? &world->tiles[(size_t)(screenRow - 1) * world->rowStride] : NULL;
+    grid.rowBelow = screenRow + TILEMAP_SIZE_Y < world->numRows ? &world->tiles[(size_t)(screenRow + TILEMAP_SIZE_Y) * world->rowStride] : NULL;
+    return grid;
+}
+
+template <typename Grid>
+inline const uint8_t* tileGridGetRow(const Grid& grid, int y) {
+    return &grid.tiles[(size_t)y * grid.rowStride];
+}
+
+// Collision mask rows of the grid: bit X of `outRows[y]` is set if tile X of row Y is full.
+// `Row` has to have at least `getSizeX()` bits (uint16_t for the game's screens, like `CollisionMask`).
+template <typename Grid, typename Row>
+inline void tileGridGetCollisionRows(const Grid& grid, Row* outRows) {
+    for (int y = 0; y < grid.getSizeY(); y++) {
+        const uint8_t* tiles = tileGridGetRow(grid, y);
+        Row row = 0;
+        for (int x = 0; x < grid.getSizeX(); x++) {
+            row |= (Row)((Row)isTileFull(tiles[x]) << x);
+        }
+        outRows[y] = row;
+    }
+}
@@ -0,0 +1,155 @@
+#include "trace.h"
+#include <stdio.h>
+
+#ifdef JUMP_PRINCE_TRACE
+
+#include <chrono>
+#include <thread>
+
+static_assert((TRACE_BUFFER_EVENTS & (TRACE_BUFFER_EVENTS - 1)) == 0, "TRACE_BUFFER_EVENTS has to be a power of two");
+
+// Bytes of the file buffer, events are written in big chunks
+#define TRACE_FILE_BUFFER (1 << 20)
+
+struct TraceEvent {
+    const char* name;
+    uint64_t startTime;
+    uint64_t endTime;
+    uint32_t threadId;
+};
+
+// Slot of the ring buffer. `sequence` says whose turn it is: the writer of event N waits for N, the reader for N + 1,
+// and the reader hands the slot to event N + TRACE_BUFFER_EVENTS once it's done with it.
+struct TraceSlot {
+    std::atomic<uint64_t> sequence;
+    TraceEvent event;
+};
+
+std::atomic<bool> isTraceActive(false);
+
+static struct {
+    // Static, so events pushed while the trace is stopping never touch freed memory
+    TraceSlot slots[TRACE_BUFFER_EVENTS];
+    std::atomic<uint64_t> writePosition;
+    // Only touched by the flush thread
+    uint64_t readPosition;
+    std::atomic<uint64_t> numDropped;
+
+    FILE* file;
+    uint64_t startTime;
+    bool isFirstEvent;
+    std::thread flushThread;
+    std::atomic<bool> isStopping;
+} trace;
+
+// Small ids (1 = first thread which traced something), easier to read in the viewer than OS ids
+static std::atomic<uint32_t> nextThreadId(1);
+
+static uint32_t getThreadId() {
+    static thread_local uint32_t threadId = 0;
+    if (threadId == 0) threadId = nextThreadId++;
+    return threadId;
+}
+
+uint64_t traceNow() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void tracePush(const char* name, uint64_t startTime, uint64_t endTime) {
+    uint64_t position = trace.writePosition.load(std::memory_order_relaxed);
+    TraceSlot* slot = NULL;
+    for (;;) {
+        slot = &trace.slots[position & (TRACE_BUFFER_EVENTS - 1)];
+        const int64_t diff = (int64_t)(slot->sequence.load(std::memory_order_acquire) - position);
+        if (diff == 0) {
+            // Slot is free, claim it (on failure `position` gets the new write position)
+            if (trace.writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        }
+        else if (diff < 0) {
+            // Full, the flush thread didn't get to this slot yet
+            trace.numDropped++;
+            return;
+        }
+        else {
+            // Another thread claimed it first
+            position = trace.writePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->event.name = name;
+    slot->event.startTime = startTime;
+    slot->event.endTime = endTime;
+    slot->event.threadId = getThreadId();
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+// Write out every event which is ready. Events are written in the order their slots were claimed,
+// a slot which was claimed but not filled yet stops the flush until the next one.
+static void flushEvents() {
+    for (;;) {
+        TraceSlot* slot = &trace.slots[trace.readPosition & (TRACE_BUFFER_EVENTS - 1)];
+        if (slot->sequence.load(std::memory_order_acquire) != trace.readPosition + 1) break;
+
+        const TraceEvent event = slot->event;
+        slot->sequence.store(trace.readPosition + TRACE_BUFFER_EVENTS, std::memory_order_release);
+        trace.readPosition++;
+
+        // Events from before the start (a scope which was already open) are clamped to it
+        const uint64_t startTime = event.startTime > trace.startTime ? event.startTime - trace.startTime : 0;
+        const uint64_t endTime = event.endTime > trace.startTime ? event.endTime - trace.startTime : 0;
+        fprintf(trace.file, "%s{\"name\":\"%s\",\"cat\":\"jump_prince\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+            trace.isFirstEvent ? "\n" : ",\n", event.name, startTime * 1e-3, (endTime - startTime) * 1e-3, event.threadId);
+        trace.isFirstEvent = false;
+    }
+}
+
+static void runFlushThread() {
+    while (!trace.isStopping.load()) {
+        flushEvents();
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_FLUSH_MS));
+    }
+    flushEvents();
+}
+
+bool traceStart(const char* path) {
+    if (trace.file) return false;
+
+    trace.file = fopen(path, "wb");
+    if (!trace.file) return false;
+    setvbuf(trace.file, NULL, _IOFBF, TRACE_FILE_BUFFER);
+    fprintf(trace.file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for (uint64_t i = 0; i < TRACE_BUFFER_EVENTS; i++) trace.slots[i].sequence.store(i);
+    trace.writePosition = 0;
+    trace.readPosition = 0;
+    trace.numDropped = 0;
+    trace.startTime = traceNow();
+    trace.isFirstEvent = true;
+    trace.isStopping = false;
+    trace.flushThread = std::thread(runFlushThread);
+    isTraceActive = true;
+    return true;
+}
+
+void traceStop() {
+    if (!trace.file) return;
+
+    isTraceActive = false;
+    trace.isStopping = true;
+    trace.flushThread.join();
+
+    fprintf(trace.file, "\n],\"otherData\":{\"droppedEvents\":%llu}}\n", (unsigned long long)trace.numDropped.load());
+    fclose(trace.file);
+    trace.file = NULL;
+}
+
+#else
+
+bool traceStart(const char* path) {
+    (void)path;
+    return false;
+}
+
+void traceStop() {}
+
+#endif
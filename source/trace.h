@@ -0,0 +1,56 @@
+// Trace export
+// ------------
+// Writes the timings of scopes (main loop phases, simulation functions, worker threads) to a Chrome Trace Event
+// JSON file, which opens in chrome://tracing or https://ui.perfetto.dev, so a hitch from a playtest can be looked at
+// frame by frame (`--trace <file>`).
+//
+// Scopes push events into a lock-free ring buffer (from any thread, a few atomic operations each),
+// and a background thread writes them out every TRACE_FLUSH_MS. If the writer falls behind and the buffer fills up,
+// events are dropped and counted, the game never waits for the file.
+//
+// Tracing is compiled in when JUMP_PRINCE_TRACE is defined (a CMake option of the same name), and even then
+// only records between `traceStart` and `traceStop`. Without the define `TRACE_SCOPE` is empty and costs nothing.
+#pragma once
+
+#include <stdint.h>
+
+// Events the ring buffer holds, has to be a power of two
+#define TRACE_BUFFER_EVENTS 65536
+#define TRACE_FLUSH_MS 10
+
+// Start writing events to the file. Returns false if it can't be opened, or tracing isn't compiled in.
+bool traceStart(const char* path);
+// Write the remaining events and close the file.
+void traceStop();
+
+#ifdef JUMP_PRINCE_TRACE
+
+#include <atomic>
+
+extern std::atomic<bool> isTraceActive;
+
+// Nanoseconds from the steady clock
+uint64_t traceNow();
+// `name` isn't copied, it has to stay valid until the trace stops (e.g. a string literal).
+void tracePush(const char* name, uint64_t startTime, uint64_t endTime);
+
+struct TraceScope {
+    const char* name;
+    uint64_t startTime;
+
+    explicit TraceScope(const char* scopeName) : name(scopeName), startTime(isTraceActive.load(std::memory_order_relaxed) ? traceNow() : 0) {}
+    ~TraceScope() {
+        if (startTime != 0) tracePush(name, startTime, traceNow());
+    }
+};
+
+#define TRACE_SCOPE_NAME2(line) traceScope##line
+#define TRACE_SCOPE_NAME(line) TRACE_SCOPE_NAME2(line)
+// Trace the rest of the C++ scope, e.g. `TRACE_SCOPE("simStep");`
+#define TRACE_SCOPE(name) TraceScope TRACE_SCOPE_NAME(__LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif
@@ -0,0 +1,258 @@
+// Physics fuzzer
+// --------------
+// Runs random input sequences through the simulation on every core and checks invariants after every tick
+// (`simStep` ends with `resolveBoxCollisionWithTilemap`):
+//  - the player's box never overlaps a full tile
+//  - position and velocity stay finite
+//  - `isOnGround` agrees with a fresh probe of the ASCII tiles (not the collision mask)
+//
+// Every episode starts from `simInit`, so a violating episode is written out as a replay
+// (fuzz_<thread>_<episode>.jprp) and can be reproduced with `--playback`.
+//
+// Meant to run for hours: the per-thread state is allocated up front (nothing is allocated while fuzzing,
+// unless a violation is written out) and every worker's state sits on its own cache lines.
+//
+// The built-in level has no ice, sand or wind, fuzz a level which has them (e.g. tools/levels/materials.txt)
+// with `--level` to cover those materials too.
+//
+//     jump_prince_fuzz [--threads <n>] [--seconds <n>] [--seed <n>] [--out <directory>] [--level <file>]
+
+#include "sim.h"
+#include "replay.h"
+#include "level_file.h"
+#include <stdio.h>
+#include <string.h> // strcmp
+#include <stdlib.h> // atoi, strtoul
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define FUZZ_MAX_THREADS 256
+// Ticks of a single episode (about half a minute of play)
+#define FUZZ_EPISODE_TICKS 4096
+// How long random inputs are held for, in ticks
+#define FUZZ_MAX_HOLD_TICKS 120
+// Stop writing replays after this many violations on one thread, they are usually all the same bug.
+#define FUZZ_MAX_TRACES_PER_THREAD 4
+// How deep the box may be inside a tile before it counts as overlapping (float rounding at surfaces)
+#define FUZZ_OVERLAP_TOLERANCE 0.001f
+// Size of a cache line, workers don't share any
+#define FUZZ_CACHE_LINE 64
+#define DEFAULT_SECONDS 10
+
+enum Violation {
+    VIOLATION_NONE,
+    VIOLATION_OVERLAP,
+    VIOLATION_NOT_FINITE,
+    VIOLATION_GROUND_PROBE,
+};
+
+static const char* violationNames[] = {
+    "none",
+    "box overlaps a full tile",
+    "position or velocity isn't finite",
+    "isOnGround disagrees with a fresh probe",
+};
+
+// Everything a worker touches while fuzzing.
+// Aligned to a cache line, so the counters of one worker don't invalidate the lines of another.
+struct alignas(FUZZ_CACHE_LINE) FuzzWorker {
+    int index;
+    uint32_t randomState;
+    SimState state;
+    // Inputs of the current episode, written out if it violates an invariant
+    Input trace[FUZZ_EPISODE_TICKS];
+    uint64_t numTicks;
+    uint64_t numEpisodes;
+    uint64_t numViolations;
+    int numTracesWritten;
+};
+
+struct Fuzzer {
+    const World* world;
+    const char* outputDirectory;
+    std::atomic<bool> isStopping;
+};
+
+// Static storage, so the alignment is honored even without C++17 aligned `new`.
+static FuzzWorker workers[FUZZ_MAX_THREADS];
+
+static_assert(sizeof(FuzzWorker) % FUZZ_CACHE_LINE == 0, "Workers have to sit on separate cache lines");
+
+// xorshift32
+static uint32_t randomU32(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// Reference version of the overlap test, straight from the ASCII tiles.
+static bool isBoxOverlappingTiles(const World* world, Vector2 center, const Vector2 size) {
+    center.y -= world->topY;
+    const int startX = (int)floorf(center.x - size.x + FUZZ_OVERLAP_TOLERANCE);
+    const int endX = (int)floorf(center.x + size.x - FUZZ_OVERLAP_TOLERANCE);
+    const int startY = (int)floorf(center.y - size.y + FUZZ_OVERLAP_TOLERANCE);
+    const int endY = (int)floorf(center.y + size.y - FUZZ_OVERLAP_TOLERANCE);
+    for (int y = startY; y <= endY; y++) {
+        for (int x = startX; x <= endX; x++) {
+            if (worldIsTileFull(world, x, y)) return true;
+        }
+    }
+    return false;
+}
+
+// Same probe as in `updatePlayer`, but on the ASCII tiles.
+static bool probeIsOnGround(const World* world, Vector2 position) {
+    const Vector2 center = { position.x, position.y + PLAYER_SIZE.y - world->topY };
+    const Vector2 size = { 0.1f, 0.05f };
+    int startX, startY, endX, endY;
+    getTilesOverlappedByBox(&startX, &startY, &endX, &endY, center, size);
+    for (int y = startY; y <= endY; y++) {
+        for (int x = startX; x <= endX; x++) {
+            if (worldIsTileFull(world, x, y)) return true;
+        }
+    }
+    return false;
+}
+
+static Violation checkTick(const World* world, const Player* player, Vector2 prevPosition) {
+    if (!isfinite(player->position.x) || !isfinite(player->position.y) ||
+        !isfinite(player->velocity.x) || !isfinite(player->velocity.y)) {
+        return VIOLATION_NOT_FINITE;
+    }
+    if (isBoxOverlappingTiles(world, player->position, PLAYER_SIZE)) return VIOLATION_OVERLAP;
+    // `isOnGround` is computed at the start of the tick, before moving
+    if (player->isOnGround != probeIsOnGround(world, prevPosition)) return VIOLATION_GROUND_PROBE;
+    return VIOLATION_NONE;
+}
+
+static void writeTrace(const Fuzzer* fuzzer, FuzzWorker* worker, int numTicks, Violation violation) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/fuzz_%i_%llu.jprp", fuzzer->outputDirectory, worker->index, (unsigned long long)worker->numEpisodes);
+
+    ReplayRecorder recorder = {};
+    if (!replayRecorderOpen(&recorder, path)) {
+        printf("thread %i: %s at tick %i, failed to write %s\n", worker->index, violationNames[violation], numTicks, path);
+        return;
+    }
+    for (int i = 0; i < numTicks; i++) {
+        replayRecord(&recorder, worker->trace[i], SIM_TICK_DELTA);
+    }
+    replayRecorderClose(&recorder);
+
+    const Player* player = &worker->state.player;
+    printf("thread %i: %s at tick %i, position (%f, %f), velocity (%f, %f), written to %s\n",
+        worker->index, violationNames[violation], numTicks,
+        player->position.x, player->position.y, player->velocity.x, player->velocity.y, path);
+}
+
+// Random input held for a random number of ticks, like a player mashing keys.
+// Jumps are charged by holding INPUT_JUMP and released by the next input.
+static void runEpisode(Fuzzer* fuzzer, FuzzWorker* worker) {
+    simInit(&worker->state, fuzzer->world);
+
+    Input input = 0;
+    int holdTicks = 0;
+    for (int tick = 0; tick < FUZZ_EPISODE_TICKS; tick++) {
+        if (holdTicks <= 0) {
+            input = (Input)(randomU32(&worker->randomState) & (INPUT_JUMP | INPUT_LEFT | INPUT_RIGHT));
+            holdTicks = 1 + (int)(randomU32(&worker->randomState) % FUZZ_MAX_HOLD_TICKS);
+        }
+        holdTicks--;
+
+        const Vector2 prevPosition = worker->state.player.position;
+        worker->trace[tick] = input;
+        simStep(&worker->state, input, SIM_TICK_DELTA);
+        worker->numTicks++;
+
+        const Violation violation = checkTick(fuzzer->world, &worker->state.player, prevPosition);
+        if (violation != VIOLATION_NONE) {
+            worker->numViolations++;
+            if (worker->numTracesWritten < FUZZ_MAX_TRACES_PER_THREAD) {
+                worker->numTracesWritten++;
+                writeTrace(fuzzer, worker, tick + 1, violation);
+            }
+            break;
+        }
+    }
+
+    worker->numEpisodes++;
+}
+
+static void runWorker(Fuzzer* fuzzer, FuzzWorker* worker) {
+    while (!fuzzer->isStopping.load(std::memory_order_relaxed)) {
+        runEpisode(fuzzer, worker);
+    }
+}
+
+int main(int argc, const char** argv) {
+    int numThreads = (int)std::thread::hardware_concurrency();
+    int numSeconds = DEFAULT_SECONDS;
+    uint32_t seed = 1;
+    const char* outputDirectory = ".";
+    const char* levelPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) numThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) numSeconds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outputDirectory = argv[++i];
+        else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) levelPath = argv[++i];
+    }
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads > FUZZ_MAX_THREADS) numThreads = FUZZ_MAX_THREADS;
+
+    World world = {};
+    LevelFile levelFile = {};
+    if (levelPath) {
+        if (!levelFileOpen(&levelFile, levelPath)) {
+            printf("failed to open level '%s'\n", levelPath);
+            return 1;
+        }
+        levelFileGetWorld(&levelFile, &world);
+    }
+    else {
+        worldInitBuiltin(&world);
+    }
+
+    Fuzzer fuzzer = {};
+    fuzzer.world = &world;
+    fuzzer.outputDirectory = outputDirectory;
+    fuzzer.isStopping = false;
+
+    for (int i = 0; i < numThreads; i++) {
+        FuzzWorker* worker = &workers[i];
+        worker->index = i;
+        // Different (and never zero) random state on every thread
+        worker->randomState = (seed * 0x9e3779b9u) ^ ((uint32_t)(i + 1) * 0x85ebca6bu);
+        if (worker->randomState == 0) worker->randomState = 1;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) threads.push_back(std::thread(runWorker, &fuzzer, &workers[i]));
+    std::this_thread::sleep_for(std::chrono::seconds(numSeconds));
+    fuzzer.isStopping = true;
+    for (std::thread& thread : threads) thread.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    uint64_t numTicks = 0;
+    uint64_t numEpisodes = 0;
+    uint64_t numViolations = 0;
+    for (int i = 0; i < numThreads; i++) {
+        numTicks += workers[i].numTicks;
+        numEpisodes += workers[i].numEpisodes;
+        numViolations += workers[i].numViolations;
+    }
+
+    printf("%llu ticks in %llu episodes on %i threads, %.0f ticks/s, %llu violations\n",
+        (unsigned long long)numTicks, (unsigned long long)numEpisodes, numThreads, numTicks / seconds,
+        (unsigned long long)numViolations);
+
+    worldFree(&world);
+    levelFileClose(&levelFile);
+    return numViolations > 0 ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+// Jump table builder
+// ------------------
+// Simulates every jump from every standing tile of the level (the built-in one, or a level file) and writes
+// the landings into a jump table file (see source/jump_table.h).
+// Screens are independent, so they are built on all cores.
+//
+//     jump_prince_jump_table [--threads <n>] [--level <file>] [output path]
+
+#include "sim.h"
+#include "jump_table.h"
+#include "level_file.h"
+#include <stdio.h>
+#include <string.h> // strcmp
+#include <stdlib.h> // atoi
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_OUTPUT_PATH "jump_table.bin"
+
+struct Builder {
+    const World* world;
+    JumpTable* table;
+    std::atomic<int> nextScreen;
+};
+
+static void runWorker(Builder* builder) {
+    for (;;) {
+        const int screen = builder->nextScreen++;
+        if (screen >= builder->world->numScreens) return;
+        jumpTableBuildScreen(builder->table, builder->world, screen);
+    }
+}
+
+int main(int argc, const char** argv) {
+    int numThreads = (int)std::thread::hardware_concurrency();
+    const char* outputPath = DEFAULT_OUTPUT_PATH;
+    const char* levelPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) numThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) levelPath = argv[++i];
+        else outputPath = argv[i];
+    }
+    if (numThreads < 1) numThreads = 1;
+
+    World world = {};
+    LevelFile levelFile = {};
+    if (levelPath) {
+        if (!levelFileOpen(&levelFile, levelPath)) {
+            printf("failed to open level '%s'\n", levelPath);
+            return 1;
+        }
+        levelFileGetWorld(&levelFile, &world);
+    }
+    else {
+        worldInitBuiltin(&world);
+    }
+    JumpTable table = {};
+    jumpTableInit(&table, &world);
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    Builder builder = {};
+    builder.world = &world;
+    builder.table = &table;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) threads.push_back(std::thread(runWorker, &builder));
+    for (std::thread& thread : threads) thread.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    uint64_t numStanding = 0;
+    uint64_t numLanded = 0;
+    const size_t numEntries = (size_t)JUMP_TABLE_SCREEN_ENTRIES * table.numScreens;
+    for (size_t i = 0; i < numEntries; i++) {
+        if (table.entries[i].isLanded) numLanded++;
+    }
+    for (int y = 0; y < world.numRows; y++) {
+        for (int x = 0; x < TILEMAP_SIZE_X; x++) {
+            if (isStandingTile(&world, x, y)) numStanding++;
+        }
+    }
+
+    printf("%i screens, %llu standing tiles, %llu of %llu jumps land, built in %.2f s on %i threads\n",
+        table.numScreens, (unsigned long long)numStanding, (unsigned long long)numLanded,
+        (unsigned long long)(numStanding * JUMP_TABLE_TILE_ENTRIES), seconds, numThreads);
+
+    const bool isSaved = jumpTableSave(&table, outputPath);
+    if (isSaved) printf("written to %s\n", outputPath);
+    else printf("failed to write %s\n", outputPath);
+
+    jumpTableFree(&table);
+    worldFree(&world);
+    levelFileClose(&levelFile);
+    return isSaved ? 0 : 1;
+}
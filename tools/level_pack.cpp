@@ -0,0 +1,126 @@
+// Level packer
+// ------------
+// Makes a level file (see source/level_file.h) from a text file, or from the built-in level.
+//
+// The text file has one line per row of tiles, `#` is a full tile and space is empty,
+// `=` is ice, `:` is sand and `<`, `>`, `^` are empty tiles with wind blowing left, right and up (see `enum Tile`),
+// the top row of the level comes first. Screens are TILEMAP_SIZE_Y rows each, the last one is the starting screen.
+// Shorter lines are filled with empty tiles, lines starting with "//" are comments.
+// With `--compress` the level is written as a compressed level file (see source/level_compress.h).
+//
+//     jump_prince_level_pack [--compress] <output.jplv> [level.txt]
+
+#include "sim.h"
+#include "level_file.h"
+#include "level_compress.h"
+#include <stdio.h>
+#include <stdlib.h> // malloc, realloc, free
+#include <string.h> // strcmp, strncmp, strcspn, memset, memcpy
+
+// Longest line of a level text file, anything longer is rejected instead of being split into two rows
+#define MAX_LINE_LENGTH 4096
+
+// Read rows of tiles from a text file into screens. Returns the number of screens, zero on failure.
+static int readLevelText(const char* path, Tilemap** outScreens) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("failed to open '%s'\n", path);
+        return 0;
+    }
+
+    Tilemap* screens = NULL;
+    int numRows = 0;
+    int lineNumber = 0;
+    char line[MAX_LINE_LENGTH + 3]; // "\r\n" and the terminator
+    while (fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        const size_t readLength = strlen(line);
+        if (readLength == sizeof(line) - 1 && line[readLength - 1] != '\n') {
+            printf("'%s' line %i is longer than %i characters\n", path, lineNumber, MAX_LINE_LENGTH);
+            fclose(file);
+            free(screens);
+            return 0;
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strncmp(line, "//", 2) == 0) continue;
+
+        if (numRows % TILEMAP_SIZE_Y == 0) {
+            screens = (Tilemap*)realloc(screens, sizeof(Tilemap) * (numRows / TILEMAP_SIZE_Y + 1));
+        }
+
+        uint8_t* row = screens[numRows / TILEMAP_SIZE_Y][numRows % TILEMAP_SIZE_Y];
+        memset(row, TILE_EMPTY, TILEMAP_SIZE_X);
+        row[TILEMAP_SIZE_X] = '\0';
+        const size_t length = strlen(line);
+        memcpy(row, line, length < TILEMAP_SIZE_X ? length : TILEMAP_SIZE_X);
+        numRows++;
+    }
+    fclose(file);
+
+    if (numRows == 0 || numRows % TILEMAP_SIZE_Y != 0) {
+        printf("'%s' has %i rows, it has to be a multiple of %i\n", path, numRows, TILEMAP_SIZE_Y);
+        free(screens);
+        return 0;
+    }
+
+    *outScreens = screens;
+    return numRows / TILEMAP_SIZE_Y;
+}
+
+int main(int argc, const char** argv) {
+    bool isCompressing = false;
+    const char* paths[2] = {};
+    int numPaths = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compress") == 0) isCompressing = true;
+        else if (numPaths < 2) paths[numPaths++] = argv[i];
+    }
+    if (numPaths < 1) {
+        printf("usage: %s [--compress] <output.jplv> [level.txt]\n", argv[0]);
+        return 1;
+    }
+    const char* outputPath = paths[0];
+
+    Tilemap* screens = NULL;
+    World world = {};
+    if (numPaths > 1) {
+        const int numScreens = readLevelText(paths[1], &screens);
+        if (numScreens == 0) return 1;
+        worldInit(&world, screens, numScreens);
+    }
+    else {
+        worldInitBuiltin(&world);
+    }
+
+    const bool isWritten = isCompressing ? levelCompressWrite(&world, outputPath) : levelFileWrite(&world, outputPath);
+    if (!isWritten) {
+        printf("failed to write '%s'\n", outputPath);
+        return 1;
+    }
+
+    // Make sure the game can open it and gets the same tiles back
+    LevelFile file = {};
+    if (!levelFileOpen(&file, outputPath)) {
+        printf("'%s' was written, but can't be opened\n", outputPath);
+        return 1;
+    }
+    World written = {};
+    levelFileGetWorld(&file, &written);
+    for (int i = 0; i < world.numScreens || i < written.numScreens; i++) {
+        if (!worldIsScreenEqual(&world, &written, i)) {
+            printf("'%s' was written, but screen %i doesn't match\n", outputPath, i);
+            return 1;
+        }
+    }
+
+    FILE* writtenFile = fopen(outputPath, "rb");
+    fseek(writtenFile, 0, SEEK_END);
+    const long fileSize = ftell(writtenFile);
+    fclose(writtenFile);
+    printf("%i screens written to %s (%li bytes)\n", world.numScreens, outputPath, fileSize);
+
+    levelFileClose(&file);
+    worldFree(&world);
+    free(screens);
+    return 0;
+}
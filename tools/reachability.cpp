@@ -0,0 +1,305 @@
+// Reachability solver
+// -------------------
+// Proves that every screen of the level can be completed.
+// Every screen is checked on its own, starting from its entrance: the standing tiles the player can land on
+// right after coming up through the bottom edge (any jump or walk from the screen below which lands on the screen).
+// The starting screen is entered where the player spawns instead.
+// From there it tries every action `updatePlayer` allows while standing (walking, and jumps with every
+// charge bucket and direction), using the real simulation, and follows every tile the player can land on,
+// including falling back into the screen below.
+//
+// Prints which standing tiles can reach which (with --edges) and flags every screen whose exit
+// (the screen above) can't be reached from its entrance. Exits with 1 if any screen is flagged.
+//
+// The search fans out over all cores: every worker has its own deque of frontier states and
+// steals from the others when it runs out of work.
+//
+//     jump_prince_reachability [--threads <n>] [--edges] [--level <file>]
+
+#include "sim.h"
+#include "jumps.h"
+#include "level_file.h"
+#include <stdio.h>
+#include <string.h> // strcmp
+#include <stdlib.h> // atoi
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Actions tried from every standing tile: two walks and every jump
+#define NUM_ACTIONS (2 + JUMP_START_OFFSETS * JUMP_CHARGE_BUCKETS * JUMP_DIRECTION_COUNT)
+
+// A transition found by the search
+struct Edge {
+    StandingTile from;
+    StandingTile to;
+};
+
+// Work-stealing queue of one worker.
+// The owner pushes and pops at the back (depth first, cache friendly), thieves take from the front.
+struct WorkQueue {
+    std::mutex mutex;
+    std::deque<StandingTile> tiles;
+};
+
+// Search of a single screen. It covers the screen, the screen above (its exit, those tiles are
+// only counted, not expanded) and the screen below (the player can fall back into it).
+struct Solver {
+    const World* world;
+    int numWorkers;
+    WorkQueue* queues;
+    // Rows of the world grid the search covers, and the first row of the screen being checked
+    int firstRow;
+    int numRows;
+    int screenRow;
+    // One flag per tile of the covered rows, set once the tile was queued.
+    std::atomic<uint8_t>* visited;
+    // Queued but not yet finished states, the search is done when this gets to zero.
+    std::atomic<int64_t> numPending;
+    std::vector<Edge>* edges; // Per worker
+    bool isCollectingEdges;
+};
+
+static int getScreenOfRow(int row) {
+    return row / TILEMAP_SIZE_Y;
+}
+
+// Every action from the tile, returns the number of results.
+static int simulateActions(const World* world, StandingTile tile, JumpResult* results) {
+    int numResults = 0;
+    results[numResults++] = simulateWalk(world, tile, JUMP_LEFT);
+    results[numResults++] = simulateWalk(world, tile, JUMP_RIGHT);
+    for (int offset = 0; offset < JUMP_START_OFFSETS; offset++) {
+        for (int charge = 0; charge < JUMP_CHARGE_BUCKETS; charge++) {
+            for (int dir = 0; dir < JUMP_DIRECTION_COUNT; dir++) {
+                results[numResults++] = simulateJump(world, tile, offset, charge, (JumpDirection)dir);
+            }
+        }
+    }
+    return numResults;
+}
+
+static void pushTile(Solver* solver, int worker, StandingTile tile) {
+    const int row = tile.y - solver->firstRow;
+    if (tile.x < 0 || tile.x >= TILEMAP_SIZE_X || row < 0 || row >= solver->numRows) return;
+
+    // Only the first one to visit a tile gets to expand it
+    if (solver->visited[row * TILEMAP_SIZE_X + tile.x].exchange(1) != 0) return;
+    // Got to the exit, nothing to search above it
+    if (tile.y < solver->screenRow) return;
+
+    solver->numPending++;
+    WorkQueue* queue = &solver->queues[worker];
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->tiles.push_back(tile);
+}
+
+static bool popTile(Solver* solver, int worker, StandingTile* outTile) {
+    // Own queue first
+    {
+        WorkQueue* queue = &solver->queues[worker];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->tiles.empty()) {
+            *outTile = queue->tiles.back();
+            queue->tiles.pop_back();
+            return true;
+        }
+    }
+
+    // Steal from the others
+    for (int i = 1; i < solver->numWorkers; i++) {
+        WorkQueue* queue = &solver->queues[(worker + i) % solver->numWorkers];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!queue->tiles.empty()) {
+            *outTile = queue->tiles.front();
+            queue->tiles.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void expandTile(Solver* solver, int worker, StandingTile tile) {
+    JumpResult results[NUM_ACTIONS];
+    const int numResults = simulateActions(solver->world, tile, results);
+
+    for (int i = 0; i < numResults; i++) {
+        if (!results[i].isLanded) continue;
+        const StandingTile landing = results[i].landing;
+        if (landing.x == tile.x && landing.y == tile.y) continue;
+
+        if (solver->isCollectingEdges) solver->edges[worker].push_back({ tile, landing });
+        pushTile(solver, worker, landing);
+    }
+}
+
+static void runWorker(Solver* solver, int worker) {
+    while (solver->numPending > 0) {
+        StandingTile tile = {};
+        if (!popTile(solver, worker, &tile)) {
+            // Someone else is still expanding, new work may show up
+            std::this_thread::yield();
+            continue;
+        }
+
+        expandTile(solver, worker, tile);
+        solver->numPending--;
+    }
+}
+
+// Standing tiles of the screen above, split between the workers (every one takes the next tile which wasn't taken yet)
+struct EntranceJob {
+    const World* world;
+    int screen;
+    std::atomic<int> nextTile;
+    // One flag per tile of the screen, set if the player can land there coming from below
+    std::atomic<uint8_t>* isEntrance;
+};
+
+static void runEntranceWorker(EntranceJob* job) {
+    const int belowRow = (job->screen + 1) * TILEMAP_SIZE_Y;
+    const int numTiles = TILEMAP_SIZE_Y * TILEMAP_SIZE_X;
+    JumpResult results[NUM_ACTIONS];
+
+    for (int i = job->nextTile++; i < numTiles; i = job->nextTile++) {
+        const StandingTile start = { i % TILEMAP_SIZE_X, belowRow + i / TILEMAP_SIZE_X };
+        if (!isStandingTile(job->world, start.x, start.y)) continue;
+
+        const int numResults = simulateActions(job->world, start, results);
+        for (int r = 0; r < numResults; r++) {
+            const StandingTile landing = results[r].landing;
+            if (!results[r].isLanded || landing.x < 0 || landing.x >= TILEMAP_SIZE_X) continue;
+            if (landing.y < 0 || getScreenOfRow(landing.y) != job->screen) continue;
+            job->isEntrance[(landing.y - job->screen * TILEMAP_SIZE_Y) * TILEMAP_SIZE_X + landing.x] = 1;
+        }
+    }
+}
+
+// Where the player lands after spawning, the entrance of the starting screen.
+static StandingTile getSpawnTile(const World* world) {
+    SimState state = {};
+    simInit(&state, world);
+    for (int i = 0; i < JUMP_MAX_TICKS && !state.player.isOnGround; i++) simStep(&state, 0, SIM_TICK_DELTA);
+    return { (int)floorf(state.player.position.x), worldGetRowAtHeight(world, state.player.position.y) };
+}
+
+static std::vector<StandingTile> findEntrance(const World* world, int screen, int numThreads) {
+    std::vector<StandingTile> entrance;
+    if (screen == world->numScreens - 1) {
+        entrance.push_back(getSpawnTile(world));
+        return entrance;
+    }
+
+    const int numTiles = TILEMAP_SIZE_Y * TILEMAP_SIZE_X;
+    EntranceJob job;
+    job.world = world;
+    job.screen = screen;
+    job.nextTile = 0;
+    job.isEntrance = new std::atomic<uint8_t>[numTiles];
+    for (int i = 0; i < numTiles; i++) job.isEntrance[i] = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) threads.push_back(std::thread(runEntranceWorker, &job));
+    for (std::thread& thread : threads) thread.join();
+
+    for (int i = 0; i < numTiles; i++) {
+        if (job.isEntrance[i]) entrance.push_back({ i % TILEMAP_SIZE_X, screen * TILEMAP_SIZE_Y + i / TILEMAP_SIZE_X });
+    }
+    delete[] job.isEntrance;
+    return entrance;
+}
+
+int main(int argc, const char** argv) {
+    int numThreads = (int)std::thread::hardware_concurrency();
+    bool isPrintingEdges = false;
+    const char* levelPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) numThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--edges") == 0) isPrintingEdges = true;
+        else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) levelPath = argv[++i];
+    }
+    if (numThreads < 1) numThreads = 1;
+
+    World world = {};
+    LevelFile levelFile = {};
+    if (levelPath) {
+        if (!levelFileOpen(&levelFile, levelPath)) {
+            printf("failed to open level '%s'\n", levelPath);
+            return 1;
+        }
+        levelFileGetWorld(&levelFile, &world);
+    }
+    else {
+        worldInitBuiltin(&world);
+    }
+
+    // Enough for the screen above, the screen and the screen below
+    const int maxTiles = 3 * TILEMAP_SIZE_Y * TILEMAP_SIZE_X;
+    Solver solver = {};
+    solver.world = &world;
+    solver.numWorkers = numThreads;
+    solver.queues = new WorkQueue[numThreads];
+    solver.visited = new std::atomic<uint8_t>[maxTiles];
+    solver.edges = new std::vector<Edge>[numThreads];
+    solver.isCollectingEdges = isPrintingEdges;
+
+    // Screens are numbered from the top, the last one is the starting screen.
+    // A screen is completed once the player can stand anywhere on the screen above it.
+    int numFlagged = 0;
+    for (int screen = world.numScreens - 1; screen >= 0; screen--) {
+        const int lastRow = (screen + 2) * TILEMAP_SIZE_Y < world.numRows ? (screen + 2) * TILEMAP_SIZE_Y : world.numRows;
+        solver.screenRow = screen * TILEMAP_SIZE_Y;
+        solver.firstRow = screen > 0 ? solver.screenRow - TILEMAP_SIZE_Y : 0;
+        solver.numRows = lastRow - solver.firstRow;
+        for (int i = 0; i < maxTiles; i++) solver.visited[i] = 0;
+        for (int w = 0; w < numThreads; w++) solver.edges[w].clear();
+
+        const std::vector<StandingTile> entrance = findEntrance(&world, screen, numThreads);
+        for (StandingTile tile : entrance) pushTile(&solver, 0, tile);
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; i++) threads.push_back(std::thread(runWorker, &solver, i));
+        for (std::thread& thread : threads) thread.join();
+
+        if (isPrintingEdges) {
+            for (int w = 0; w < numThreads; w++) {
+                for (const Edge& edge : solver.edges[w]) {
+                    printf("screen %i: [%i,%i] -> [%i,%i]\n", screen, edge.from.x, edge.from.y, edge.to.x, edge.to.y);
+                }
+            }
+        }
+
+        int numReached = 0;
+        int numExitReached = 0;
+        for (int i = 0; i < solver.numRows * TILEMAP_SIZE_X; i++) {
+            if (!solver.visited[i]) continue;
+            const int row = solver.firstRow + i / TILEMAP_SIZE_X;
+            if (row < solver.screenRow) numExitReached++;
+            else if (getScreenOfRow(row) == screen) numReached++;
+        }
+
+        const bool isTop = screen == 0;
+        const char* status = "ok";
+        if (entrance.empty()) {
+            status = "NO ENTRANCE";
+            numFlagged++;
+        }
+        else if (!isTop && numExitReached == 0) {
+            status = "EXIT NOT REACHABLE";
+            numFlagged++;
+        }
+        printf("screen %3i: %3i entrance tiles, %3i standing tiles reached, %s\n", screen, (int)entrance.size(), numReached, status);
+    }
+
+    printf("%i screens, %i threads, %i flagged\n", world.numScreens, numThreads, numFlagged);
+
+    delete[] solver.queues;
+    delete[] solver.visited;
+    delete[] solver.edges;
+    worldFree(&world);
+    levelFileClose(&levelFile);
+    return numFlagged > 0 ? 1 : 0;
+}